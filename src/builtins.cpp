@@ -0,0 +1,29 @@
+#include "builtins.h"
+#include <unordered_map>
+
+static constexpr int ANY = -1;
+static constexpr uint8_t ROUTED = BUILTIN_ROUTED;
+static constexpr uint8_t PURE = BUILTIN_PURE;
+static constexpr uint8_t NULLARY = BUILTIN_NULLARY;
+
+static const BuiltinInfo builtin_table[] = {
+#define LANG_BUILTIN_INFO(name, max_args, flags) { #name, max_args, flags },
+    LANG_BUILTINS(LANG_BUILTIN_INFO)
+#undef LANG_BUILTIN_INFO
+    { "", ANY, 0 }      // Builtin::Unknown
+};
+
+Builtin builtin_id(const std::string& name) {
+    static const std::unordered_map<std::string, Builtin> ids = [] {
+        std::unordered_map<std::string, Builtin> m;
+        for (size_t i = 0; i < (size_t)Builtin::Unknown; i++)
+            m.emplace(builtin_table[i].name, (Builtin)i);
+        return m;
+    }();
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : Builtin::Unknown;
+}
+
+const BuiltinInfo& builtin_info(Builtin id) {
+    return builtin_table[(size_t)id];
+}
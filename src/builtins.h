@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// ── Built-in functions ────────────────────────────────────────────────────
+// The single registry of built-ins, shared by the parser and the interpreter.
+// A call to any name listed here parses to a StringOpNode whose Builtin id is
+// resolved once, and the interpreter switches on that id (call_builtin).
+// Adding a built-in means one entry here plus its case in call_builtin.
+//
+//   X(name, max_args, flags)
+//   max_args  arguments kept by the parser, target included (ANY = no limit);
+//             extras are dropped
+//   flags     ROUTED — also callable in statement position, where the
+//             parser otherwise produces a FuncCallNode
+//             PURE — result depends only on the arguments, with no side
+//             effects, so calls on literals are folded (optimizer.h)
+//             NULLARY — may be called with no arguments; the target is
+//             then Null
+#define LANG_BUILTINS(X) \
+    /* Strings and arrays */ \
+    X(Length, 1, PURE) X(Upper, 1, PURE) X(Lower, 1, PURE) X(Push, 2, 0) X(Pop, 1, 0) \
+    X(Contains, ANY, PURE) X(Substring, ANY, PURE) \
+    /* Math */ \
+    X(Floor, ANY, PURE) X(Ceil, ANY, PURE) X(Round, ANY, PURE) X(Sqrt, ANY, PURE) \
+    X(Abs, ANY, PURE) X(Power, ANY, PURE) X(Sin, ANY, PURE) X(Cos, ANY, PURE) \
+    X(Tan, ANY, PURE) X(Asin, ANY, PURE) X(Acos, ANY, PURE) X(Atan, ANY, PURE) \
+    X(Atan2, ANY, PURE) X(Mod, ANY, PURE) X(Min, ANY, PURE) X(Max, ANY, PURE) \
+    X(Clamp, ANY, PURE) X(Lerp, ANY, PURE) X(Log, ANY, PURE) X(Log10, ANY, PURE) \
+    X(Log2, ANY, PURE) X(Exp, ANY, PURE) X(Sinh, ANY, PURE) X(Cosh, ANY, PURE) \
+    X(Tanh, ANY, PURE) X(Asinh, ANY, PURE) X(Acosh, ANY, PURE) X(Atanh, ANY, PURE) \
+    X(Deg2Rad, ANY, PURE) X(Rad2Deg, ANY, PURE) X(Factorial, ANY, PURE) \
+    X(IsPrime, ANY, PURE) X(GCD, ANY, PURE) X(LCM, ANY, PURE) X(RandomInt, ANY, 0) \
+    X(Sign, ANY, PURE) X(Truncate, ANY, PURE) X(Frac, ANY, PURE) X(Hypot, ANY, PURE) \
+    X(Cbrt, ANY, PURE) X(CopySign, ANY, PURE) X(LogBase, ANY, PURE) \
+    X(Gamma, ANY, PURE) X(Beta, ANY, PURE) X(Erf, ANY, PURE) X(Erfc, ANY, PURE) \
+    /* Number checks */ \
+    X(IsNaN, ANY, PURE) X(IsInf, ANY, PURE) X(IsEven, ANY, PURE) X(IsOdd, ANY, PURE) \
+    /* Bitwise */ \
+    X(BitAnd, ANY, PURE) X(BitOr, ANY, PURE) X(BitXor, ANY, PURE) X(BitNot, ANY, PURE) \
+    X(BitShiftLeft, ANY, PURE) X(BitShiftRight, ANY, PURE) \
+    /* Statistics */ \
+    X(Sum, ANY, 0) X(Product, ANY, 0) X(Mean, ANY, 0) X(Median, ANY, 0) \
+    X(Variance, ANY, 0) X(StdDev, ANY, 0) \
+    /* Type checks */ \
+    X(IsNull, ANY, ROUTED | PURE) X(IsDict, ANY, ROUTED | PURE) \
+    X(IsArray, ANY, ROUTED | PURE) X(IsString, ANY, ROUTED | PURE) \
+    X(IsNumber, ANY, ROUTED | PURE) X(IsBool, ANY, ROUTED | PURE) \
+    /* Type conversion */ \
+    X(ToNumber, 1, PURE) X(ToString, 1, PURE) \
+    X(NumberArray, 1, 0) X(ToNumberArray, 1, 0) \
+    /* Cycle collector (gc.h) */ \
+    X(GcCollect, 1, ROUTED | NULLARY) X(GcStats, 1, ROUTED | NULLARY) \
+    /* Dictionaries and JSON */ \
+    X(DictKeys, ANY, ROUTED) X(DictValues, ANY, ROUTED) \
+    X(DictHas, ANY, ROUTED) X(DictRemove, ANY, ROUTED) \
+    X(DictSize, ANY, ROUTED) X(DictMerge, ANY, ROUTED) \
+    X(JsonParse, ANY, ROUTED) X(JsonStringify, ANY, ROUTED) \
+    /* TCP sockets */ \
+    X(SocketConnect, ANY, ROUTED) X(SocketListen, ANY, ROUTED) \
+    X(SocketAccept, ANY, ROUTED) X(SocketSend, ANY, ROUTED) \
+    X(SocketReceive, ANY, ROUTED) X(SocketReceiveLine, ANY, ROUTED) \
+    X(SocketClose, ANY, ROUTED) X(SocketIsValid, ANY, ROUTED) \
+    X(SocketSetTimeout, ANY, ROUTED) \
+    /* DNS */ \
+    X(DnsResolve, ANY, ROUTED) X(DnsResolveAll, ANY, ROUTED) \
+    X(DnsResolveIPv6, ANY, ROUTED) X(DnsReverse, ANY, ROUTED) \
+    /* HTTP client */ \
+    X(HttpGet, ANY, ROUTED) X(HttpPost, ANY, ROUTED) \
+    X(HttpPut, ANY, ROUTED) X(HttpDelete, ANY, ROUTED) \
+    X(HttpStatusCode, ANY, ROUTED) X(HttpHeaders, ANY, ROUTED) \
+    X(HttpRequest, ANY, ROUTED) X(HttpRequestStatus, ANY, ROUTED) \
+    X(HttpDownload, ANY, ROUTED) X(HttpGetJson, ANY, ROUTED) \
+    X(HttpPostJson, ANY, ROUTED) X(HttpGetWithTimeout, ANY, ROUTED) \
+    X(HttpGetFull, ANY, ROUTED) \
+    /* HTTP server */ \
+    X(HttpServerCreate, ANY, ROUTED) X(HttpServerAccept, ANY, ROUTED) \
+    X(HttpServerClose, ANY, ROUTED) X(HttpConnClose, ANY, ROUTED) \
+    X(HttpRequestMethod, ANY, ROUTED) X(HttpRequestPath, ANY, ROUTED) \
+    X(HttpRequestBody, ANY, ROUTED) X(HttpRequestHeader, ANY, ROUTED) \
+    X(HttpRequestParam, ANY, ROUTED) X(HttpRequestQuery, ANY, ROUTED) \
+    X(HttpRequestIP, ANY, ROUTED) X(HttpRespond, ANY, ROUTED) \
+    X(HttpRespondFile, ANY, ROUTED) X(HttpRespondJson, ANY, ROUTED) \
+    X(HttpRespondRedirect, ANY, ROUTED) \
+    /* WebSocket */ \
+    X(WsConnect, ANY, ROUTED) X(WsSend, ANY, ROUTED) \
+    X(WsReceive, ANY, ROUTED) X(WsReceiveLine, ANY, ROUTED) \
+    X(WsClose, ANY, ROUTED) X(WsIsConnected, ANY, ROUTED) \
+    /* UDP */ \
+    X(UdpCreate, ANY, ROUTED) X(UdpSend, ANY, ROUTED) \
+    X(UdpReceive, ANY, ROUTED) X(UdpReceiveFull, ANY, ROUTED) \
+    X(UdpSetTimeout, ANY, ROUTED) X(UdpClose, ANY, ROUTED) \
+    X(UdpBroadcast, ANY, ROUTED)
+
+enum class Builtin : uint16_t {
+#define LANG_BUILTIN_ENUM(name, max_args, flags) name,
+    LANG_BUILTINS(LANG_BUILTIN_ENUM)
+#undef LANG_BUILTIN_ENUM
+    Unknown
+};
+
+constexpr uint8_t BUILTIN_ROUTED = 1 << 0;
+constexpr uint8_t BUILTIN_PURE   = 1 << 1;
+constexpr uint8_t BUILTIN_NULLARY = 1 << 2;
+
+struct BuiltinInfo {
+    const char* name;
+    int max_args;       // -1 = any
+    uint8_t flags;
+};
+
+// Builtin::Unknown if name is not a built-in
+Builtin builtin_id(const std::string& name);
+const BuiltinInfo& builtin_info(Builtin id);
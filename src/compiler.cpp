@@ -0,0 +1,369 @@
+#include "compiler.h"
+
+std::unique_ptr<Chunk> Compiler::compile_program(const std::vector<NodePtr>& program) {
+    auto result = std::make_unique<Chunk>();
+    chunk = result.get();
+    loops.clear();
+    try_depth = 0;
+    block(program);
+    emit(OpCode::CONST, add_constant(Value::make_null()));
+    emit(OpCode::RETURN);
+    chunk = nullptr;
+    return result;
+}
+
+std::unique_ptr<Chunk> Compiler::compile_function(FuncDefNode* func) {
+    auto result = std::make_unique<Chunk>();
+    chunk = result.get();
+    loops.clear();
+    try_depth = 0;
+    block(func->body);
+    // Falling off the end returns Null
+    emit(OpCode::CONST, add_constant(Value::make_null()));
+    emit(OpCode::RETURN);
+    chunk = nullptr;
+    return result;
+}
+
+size_t Compiler::emit(OpCode op, int32_t a, int32_t b) {
+    Instr in;
+    in.op = op;
+    in.a = a;
+    in.b = b;
+    chunk->code.push_back(in);
+    return chunk->code.size() - 1;
+}
+
+int32_t Compiler::add_constant(const Value& v) {
+    chunk->constants.push_back(v);
+    return (int32_t)chunk->constants.size() - 1;
+}
+
+int32_t Compiler::add_name(const std::string& name) {
+    for (size_t i = 0; i < chunk->names.size(); i++)
+        if (chunk->names[i] == name) return (int32_t)i;
+    chunk->names.push_back(name);
+    return (int32_t)chunk->names.size() - 1;
+}
+
+int32_t Compiler::add_node(ASTNode* node) {
+    chunk->nodes.push_back(node);
+    return (int32_t)chunk->nodes.size() - 1;
+}
+
+void Compiler::load(const VarRef& ref, const std::string& name) {
+    emit(ref.local ? OpCode::LOAD_LOCAL : OpCode::LOAD_GLOBAL, ref.slot, add_name(name));
+}
+
+void Compiler::store(const VarRef& ref) {
+    emit(ref.local ? OpCode::STORE_LOCAL : OpCode::STORE_GLOBAL, ref.slot);
+}
+
+// Break/Continue jumping out of Try blocks must drop their handlers first
+void Compiler::leave_try_blocks(int depth) {
+    for (int i = try_depth; i > depth; i--)
+        emit(OpCode::TRY_END);
+}
+
+void Compiler::block(const std::vector<NodePtr>& stmts) {
+    for (const auto& stmt : stmts)
+        statement(stmt.get());
+}
+
+void Compiler::statement(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::ASSIGNMENT: {
+            auto* n = static_cast<AssignmentNode*>(node);
+            // x = x + e appends to x's string in place when it can
+            if (n->value->type == NodeType::BINARY_OP) {
+                auto* bin = static_cast<BinaryOpNode*>(n->value.get());
+                auto* var = static_cast<VariableNode*>(bin->left.get());
+                if (bin->op == TokenType::PLUS && bin->left->type == NodeType::VARIABLE &&
+                    var->ref.slot == n->ref.slot && var->ref.local == n->ref.local) {
+                    load(var->ref, var->name);
+                    expression(bin->right.get());
+                    emit(n->ref.local ? OpCode::APPEND_LOCAL : OpCode::APPEND_GLOBAL, n->ref.slot);
+                    break;
+                }
+            }
+            expression(n->value.get());
+            store(n->ref);
+            break;
+        }
+
+        case NodeType::DICT_ASSIGN: {
+            auto* n = static_cast<DictAssignNode*>(node);
+            expression(n->key.get());
+            expression(n->value.get());
+            emit(n->ref.local ? OpCode::STORE_INDEX_LOCAL : OpCode::STORE_INDEX_GLOBAL,
+                 n->ref.slot, add_name(n->name));
+            break;
+        }
+
+        case NodeType::PRINT:
+            expression(static_cast<PrintNode*>(node)->expression.get());
+            emit(OpCode::PRINT);
+            break;
+
+        case NodeType::IF_STATEMENT: {
+            auto* n = static_cast<IfStatementNode*>(node);
+            std::vector<size_t> to_end;
+            condition(n->condition.get());
+            size_t next = emit(OpCode::JUMP_IF_FALSE);
+            block(n->body);
+            to_end.push_back(emit(OpCode::JUMP));
+            for (auto& clause : n->elif_clauses) {
+                patch(next, here());
+                condition(clause.condition.get());
+                next = emit(OpCode::JUMP_IF_FALSE);
+                block(clause.body);
+                to_end.push_back(emit(OpCode::JUMP));
+            }
+            patch(next, here());
+            block(n->else_body);
+            for (size_t j : to_end) patch(j, here());
+            break;
+        }
+
+        case NodeType::WHILE_LOOP: {
+            auto* n = static_cast<WhileLoopNode*>(node);
+            size_t top = here();
+            condition(n->condition.get());
+            size_t exit = emit(OpCode::JUMP_IF_FALSE);
+            loops.push_back(LoopInfo{{}, {}, try_depth});
+            block(n->body);
+            emit(OpCode::JUMP, (int32_t)top);
+            LoopInfo loop = std::move(loops.back());
+            loops.pop_back();
+            patch(exit, here());
+            for (size_t j : loop.breaks) patch(j, here());
+            for (size_t j : loop.continues) patch(j, top);
+            break;
+        }
+
+        case NodeType::FOR_LOOP: {
+            // Stack while looping: [counter, limit]
+            auto* n = static_cast<ForLoopNode*>(node);
+            expression(n->start.get());
+            expression(n->end.get());
+            emit(OpCode::FOR_PREP);
+            size_t top = here();
+            size_t exit = emit(OpCode::FOR_TEST);
+            emit(n->var_ref.local ? OpCode::FOR_STORE_LOCAL : OpCode::FOR_STORE_GLOBAL, n->var_ref.slot);
+            loops.push_back(LoopInfo{{}, {}, try_depth});
+            block(n->body);
+            LoopInfo loop = std::move(loops.back());
+            loops.pop_back();
+            for (size_t j : loop.continues) patch(j, here());
+            emit(OpCode::FOR_STEP);
+            emit(OpCode::JUMP, (int32_t)top);
+            patch(exit, here());
+            for (size_t j : loop.breaks) patch(j, here());
+            emit(OpCode::POP, 2);
+            break;
+        }
+
+        case NodeType::BREAK_STATEMENT:
+            if (loops.empty()) { emit(OpCode::EXEC, 0, add_node(node)); break; }
+            leave_try_blocks(loops.back().try_depth);
+            loops.back().breaks.push_back(emit(OpCode::JUMP));
+            break;
+
+        case NodeType::CONTINUE_STATEMENT:
+            if (loops.empty()) { emit(OpCode::EXEC, 0, add_node(node)); break; }
+            leave_try_blocks(loops.back().try_depth);
+            loops.back().continues.push_back(emit(OpCode::JUMP));
+            break;
+
+        case NodeType::RETURN_STATEMENT: {
+            auto* n = static_cast<ReturnNode*>(node);
+            if (n->tail_call && !Interpreter::is_routed_call(static_cast<FuncCallNode*>(n->value.get())->name)) {
+                auto* call = static_cast<FuncCallNode*>(n->value.get());
+                for (auto& arg : call->args) expression(arg.get());
+                emit(OpCode::TAIL_CALL, (int32_t)call->args.size(), add_node(call));
+            } else {
+                expression(n->value.get());
+            }
+            emit(OpCode::RETURN);
+            break;
+        }
+
+        case NodeType::TRY_CATCH: {
+            auto* n = static_cast<TryCatchNode*>(node);
+            size_t begin = emit(OpCode::TRY_BEGIN, 0, add_node(node));
+            try_depth++;
+            block(n->try_body);
+            try_depth--;
+            emit(OpCode::TRY_END);
+            size_t to_end = emit(OpCode::JUMP);
+            patch(begin, here());   // the VM binds the error variable before jumping here
+            block(n->catch_body);
+            patch(to_end, here());
+            break;
+        }
+
+        case NodeType::FUNC_CALL: {
+            auto* n = static_cast<FuncCallNode*>(node);
+            // Push/Pop statements have their own in-place semantics
+            if (n->name == "Push" || n->name == "Pop") {
+                emit(OpCode::EXEC, 0, add_node(node));
+                break;
+            }
+            expression(node);
+            emit(OpCode::POP, 1);
+            break;
+        }
+
+        case NodeType::STRING_OP:
+            expression(node);
+            emit(OpCode::POP, 1);
+            break;
+
+        default:
+            // File writes, Func definitions, imports
+            emit(OpCode::EXEC, 0, add_node(node));
+            break;
+    }
+}
+
+void Compiler::expression(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::NUMBER:
+            emit(OpCode::CONST, add_constant(Value(static_cast<NumberNode*>(node)->value)));
+            break;
+
+        case NodeType::STRING:
+            emit(OpCode::CONST, add_constant(Value(static_cast<StringNode*>(node)->value)));
+            break;
+
+        case NodeType::BOOLEAN:
+            emit(OpCode::CONST, add_constant(Value(static_cast<BooleanNode*>(node)->value)));
+            break;
+
+        case NodeType::NULL_LITERAL:
+            emit(OpCode::CONST, add_constant(Value::make_null()));
+            break;
+
+        case NodeType::INTERP_STRING: {
+            auto* n = static_cast<InterpStringNode*>(node);
+            for (auto& seg : n->segments) {
+                if (seg.is_expr) expression(seg.expr.get());
+                else emit(OpCode::CONST, add_constant(Value(seg.literal)));
+            }
+            emit(OpCode::CONCAT, (int32_t)n->segments.size());
+            break;
+        }
+
+        case NodeType::ARRAY: {
+            auto* n = static_cast<ArrayNode*>(node);
+            for (auto& elem : n->elements) expression(elem.get());
+            emit(OpCode::BUILD_ARRAY, (int32_t)n->elements.size());
+            break;
+        }
+
+        case NodeType::DICT: {
+            auto* n = static_cast<DictNode*>(node);
+            for (auto& [k, v] : n->pairs) {
+                expression(k.get());
+                expression(v.get());
+            }
+            emit(OpCode::BUILD_DICT, (int32_t)n->pairs.size());
+            break;
+        }
+
+        case NodeType::VARIABLE: {
+            auto* n = static_cast<VariableNode*>(node);
+            load(n->ref, n->name);
+            break;
+        }
+
+        case NodeType::DICT_ACCESS: {
+            auto* n = static_cast<DictAccessNode*>(node);
+            load(n->ref, n->name);
+            expression(n->key.get());
+            emit(OpCode::INDEX, 0, add_name(n->name));
+            break;
+        }
+
+        case NodeType::BINARY_OP: {
+            auto* n = static_cast<BinaryOpNode*>(node);
+            expression(n->left.get());
+            expression(n->right.get());
+            switch (n->op) {
+                case TokenType::PLUS:     emit(OpCode::ADD); break;
+                case TokenType::MINUS:    emit(OpCode::SUB); break;
+                case TokenType::MULTIPLY: emit(OpCode::MUL); break;
+                case TokenType::DIVIDE:   emit(OpCode::DIV); break;
+                default: throw std::runtime_error("Unknown operator");
+            }
+            break;
+        }
+
+        case NodeType::COMPARISON:
+            // Only conditions may hold comparisons: EVAL has the tree walker
+            // raise "Invalid node type in expression" when this is reached,
+            // as it would itself
+            emit(OpCode::EVAL, 0, add_node(node));
+            break;
+
+        case NodeType::LOGICAL_OP: {
+            // Short-circuit; the result is always a Boolean
+            auto* n = static_cast<LogicalOpNode*>(node);
+            bool is_and = n->op == TokenType::AND;
+            condition(n->left.get());
+            if (!is_and) emit(OpCode::NOT);
+            size_t short_circuit = emit(OpCode::JUMP_IF_FALSE);
+            condition(n->right.get());
+            emit(OpCode::NOT);   // NOT NOT: coerce to Boolean
+            emit(OpCode::NOT);
+            size_t to_end = emit(OpCode::JUMP);
+            patch(short_circuit, here());
+            emit(OpCode::CONST, add_constant(Value(!is_and)));
+            patch(to_end, here());
+            break;
+        }
+
+        case NodeType::NOT_OP:
+            condition(static_cast<NotOpNode*>(node)->operand.get());
+            emit(OpCode::NOT);
+            break;
+
+        case NodeType::FUNC_CALL: {
+            auto* n = static_cast<FuncCallNode*>(node);
+            if (Interpreter::is_routed_call(n->name)) {
+                emit(OpCode::EVAL, 0, add_node(node));
+                break;
+            }
+            for (auto& arg : n->args) expression(arg.get());
+            emit(OpCode::CALL, (int32_t)n->args.size(), add_node(node));
+            break;
+        }
+
+        default:
+            // Built-ins (StringOpNode), Input, ReadFile, LANGPACK imports
+            emit(OpCode::EVAL, 0, add_node(node));
+            break;
+    }
+}
+
+// A value whose truthiness is Interpreter::evaluate_condition(node): the
+// operand of If/Elif/While, And/Or and Not, the only places a comparison
+// is accepted
+void Compiler::condition(ASTNode* node) {
+    if (node->type != NodeType::COMPARISON) {
+        expression(node);
+        return;
+    }
+    auto* n = static_cast<ComparisonNode*>(node);
+    expression(n->left.get());
+    expression(n->right.get());
+    switch (n->op) {
+        case TokenType::EQUAL:         emit(OpCode::EQ); break;
+        case TokenType::NOT_EQUAL:     emit(OpCode::NE); break;
+        case TokenType::LESS_THAN:     emit(OpCode::LT); break;
+        case TokenType::GREATER_THAN:  emit(OpCode::GT); break;
+        case TokenType::LESS_EQUAL:    emit(OpCode::LE); break;
+        case TokenType::GREATER_EQUAL: emit(OpCode::GE); break;
+        default: throw std::runtime_error("Unknown comparison operator");
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "interpreter.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ── Bytecode ──────────────────────────────────────────────────────────────
+// One list drives both the OpCode enum and the VM's dispatch table.
+// Operands: a / b as noted; "name" means an index into Chunk::names,
+// "node" an index into Chunk::nodes.
+#define LANG_OPCODES(X) \
+    X(CONST)              /* push constants[a]                                 */ \
+    X(POP)                /* drop a values                                     */ \
+    X(LOAD_LOCAL)         /* push frame slot a (b = name)                      */ \
+    X(LOAD_GLOBAL)        /* push global slot a (b = name)                     */ \
+    X(STORE_LOCAL)        /* pop into frame slot a                             */ \
+    X(STORE_GLOBAL)       /* pop into global slot a                            */ \
+    X(APPEND_LOCAL)       /* pop right, left; frame slot a = left + right      */ \
+    X(APPEND_GLOBAL)      /* pop right, left; global slot a = left + right     */ \
+    X(INDEX)              /* pop key, container; push element (b = name)       */ \
+    X(STORE_INDEX_LOCAL)  /* pop value, key; store into frame slot a (b = name) */ \
+    X(STORE_INDEX_GLOBAL) /* pop value, key; store into global slot a          */ \
+    X(ADD) X(SUB) X(MUL) X(DIV) \
+    X(EQ) X(NE) X(LT) X(GT) X(LE) X(GE) \
+    X(NOT) \
+    X(JUMP)               /* ip = a                                            */ \
+    X(JUMP_IF_FALSE)      /* pop; if falsy ip = a                              */ \
+    X(BUILD_ARRAY)        /* pop a elements, push array                        */ \
+    X(BUILD_DICT)         /* pop a key/value pairs, push dict                  */ \
+    X(CONCAT)             /* pop a values, push their strings joined           */ \
+    X(PRINT) \
+    X(CALL)               /* a = argc, b = node (FuncCallNode)                 */ \
+    X(RETURN) \
+    X(TAIL_CALL)          /* CALL, but a self call rebinds the frame (ip = 0)  */ \
+    X(FOR_PREP)           /* start, end → numeric loop counter and limit       */ \
+    X(FOR_TEST)           /* if counter > limit ip = a                         */ \
+    X(FOR_STORE_LOCAL)    /* frame slot a = counter                            */ \
+    X(FOR_STORE_GLOBAL)   /* global slot a = counter                           */ \
+    X(FOR_STEP)           /* counter += 1                                      */ \
+    X(TRY_BEGIN)          /* push handler at a (b = node, the TryCatchNode)    */ \
+    X(TRY_END)            /* pop handler                                       */ \
+    X(EVAL)               /* push Interpreter::evaluate(node b)                */ \
+    X(EXEC)               /* Interpreter::execute_statement(node b)            */
+
+enum class OpCode : uint8_t {
+#define LANG_OPCODE_ENUM(name) name,
+    LANG_OPCODES(LANG_OPCODE_ENUM)
+#undef LANG_OPCODE_ENUM
+};
+
+struct Instr {
+    OpCode op;
+    int32_t a = 0;
+    int32_t b = 0;
+};
+
+// A compiled program or function body
+struct Chunk {
+    std::vector<Instr> code;
+    std::vector<Value> constants;
+    std::vector<std::string> names;
+    std::vector<ASTNode*> nodes;   // fallback nodes run by the tree walker
+};
+
+// Compiler — lowers a resolved AST (see resolver.h) to a linear Chunk.
+// Node kinds without a dedicated instruction are emitted as EVAL / EXEC so
+// the tree walker runs them; control flow, variables, operators and user
+// function calls are all native bytecode.
+class Compiler {
+public:
+    std::unique_ptr<Chunk> compile_program(const std::vector<NodePtr>& program);
+    std::unique_ptr<Chunk> compile_function(FuncDefNode* func);
+
+private:
+    struct LoopInfo {
+        std::vector<size_t> breaks;
+        std::vector<size_t> continues;
+        int try_depth = 0;
+    };
+
+    Chunk* chunk = nullptr;
+    std::vector<LoopInfo> loops;
+    int try_depth = 0;
+
+    size_t emit(OpCode op, int32_t a = 0, int32_t b = 0);
+    void patch(size_t at, size_t target) { chunk->code[at].a = (int32_t)target; }
+    size_t here() const { return chunk->code.size(); }
+    int32_t add_constant(const Value& v);
+    int32_t add_name(const std::string& name);
+    int32_t add_node(ASTNode* node);
+
+    void load(const VarRef& ref, const std::string& name);
+    void store(const VarRef& ref);
+    void leave_try_blocks(int depth);
+
+    void block(const std::vector<NodePtr>& stmts);
+    void statement(ASTNode* node);
+    void expression(ASTNode* node);
+    void condition(ASTNode* node);
+};
@@ -0,0 +1,104 @@
+#include "gc.h"
+#include "value.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+void Gc::attach() {
+    if (!heap) heap = new Heap();   // lives as long as the thread's containers may
+}
+
+static RcBase* box_of(GcLink* link) {
+    if (link->is_dict) return static_cast<RcBox<Dict>*>(link);
+    return static_cast<RcBox<Array>*>(link);
+}
+
+template <typename F>
+static void for_each_child(GcLink* link, F f) {
+    if (link->is_dict) {
+        for (const auto& entry : static_cast<RcBox<Dict>*>(link)->value)
+            if (GcLink* child = entry.second.gc_link()) f(child);
+    } else {
+        for (const Value& elem : static_cast<RcBox<Array>*>(link)->value)
+            if (GcLink* child = elem.gc_link()) f(child);
+    }
+}
+
+size_t Gc::collect() {
+    pending = false;
+    Heap* h = heap;
+    if (!h) return 0;
+    auto start = std::chrono::steady_clock::now();
+
+    // 1–2: what is left of each count once references from listed
+    // containers are taken away came from outside the list
+    for (GcLink* l = h->head; l; l = l->next) l->gc_refs = box_of(l)->count();
+    for (GcLink* l = h->head; l; l = l->next)
+        for_each_child(l, [](GcLink* child) {
+            if (child->tracked) child->gc_refs--;
+        });
+
+    // 3: everything reachable from those is live
+    const uint32_t LIVE = UINT32_MAX;
+    std::vector<GcLink*> work;
+    for (GcLink* l = h->head; l; l = l->next) {
+        if (l->gc_refs > 0) {
+            l->gc_refs = LIVE;
+            work.push_back(l);
+        }
+    }
+    while (!work.empty()) {
+        GcLink* l = work.back();
+        work.pop_back();
+        for_each_child(l, [&](GcLink* child) {
+            if (child->tracked && child->gc_refs != LIVE) {
+                child->gc_refs = LIVE;
+                work.push_back(child);
+            }
+        });
+    }
+
+    // 4: hold a reference to each unreachable container so none is freed
+    // while the others are emptied, then let the counts finish the job
+    std::vector<Value> garbage;
+    for (GcLink* l = h->head; l; l = l->next) {
+        if (l->gc_refs == LIVE) continue;
+        if (l->is_dict) garbage.emplace_back(Rc<Dict>::share(static_cast<RcBox<Dict>*>(l)));
+        else garbage.emplace_back(Rc<Array>::share(static_cast<RcBox<Array>*>(l)));
+    }
+    uint64_t bytes = 0;
+    for (Value& v : garbage) {
+        if (v.is_dict()) {
+            bytes += sizeof(RcBox<Dict>) + v.dict()->bytes();
+            *v.dict() = Dict();
+        } else {
+            bytes += sizeof(RcBox<Array>) + v.array()->capacity() * sizeof(Value);
+            Array().swap(*v.array());
+        }
+    }
+    size_t freed = garbage.size();
+    garbage.clear();
+
+    h->allocations = 0;
+    h->threshold = std::max(MIN_THRESHOLD, h->count);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Stats& s = h->stats;
+    s.collections++;
+    s.freed += freed;
+    s.bytes_freed += bytes;
+    s.pause_ms += ms;
+    s.last_pause_ms = ms;
+    return freed;
+}
+
+Gc::Stats Gc::stats() {
+    return heap ? heap->stats : Stats();
+}
+
+size_t Gc::tracked() {
+    return heap ? heap->count : 0;
+}
+
+size_t Gc::threshold() {
+    return heap ? heap->threshold : MIN_THRESHOLD;
+}
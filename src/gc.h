@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ── Cycle collector ───────────────────────────────────────────────────────
+// Reference counting frees everything except arrays and dicts that end up
+// holding themselves, directly or through each other (d["self"] = d). Every
+// array and dict made on the interpreter's thread is linked into a list;
+// once enough have been made since the last pass, the next safe point runs
+// a trial deletion over the list, as CPython's collector does:
+//   1. copy each container's reference count into gc_refs,
+//   2. subtract the references the listed containers hold to one another,
+//   3. a container left above zero is referenced from outside (a variable,
+//      the VM stack, a temporary); it and everything it reaches are live,
+//   4. the rest are garbage: they are emptied, which breaks the cycles, and
+//      then freed by their counts dropping to zero.
+// Containers shared across threads (Value::share_across_threads) leave the
+// list and are treated as live from then on.
+struct GcLink {
+    GcLink* prev = nullptr;
+    GcLink* next = nullptr;
+    uint32_t gc_refs = 0;
+    bool is_dict = false;
+    bool tracked = false;
+};
+
+class Gc {
+public:
+    struct Stats {
+        uint64_t collections = 0;
+        uint64_t freed = 0;          // arrays and dicts
+        uint64_t bytes_freed = 0;    // their boxes and element storage
+        double pause_ms = 0;         // all collections
+        double last_pause_ms = 0;
+    };
+
+    // Containers made on the calling thread are tracked from now on
+    static void attach();
+
+    static void track(GcLink* link, bool is_dict) {
+        Heap* h = heap;
+        if (!h) return;
+        link->is_dict = is_dict;
+        link->tracked = true;
+        link->next = h->head;
+        if (h->head) h->head->prev = link;
+        h->head = link;
+        h->count++;
+        if (++h->allocations >= h->threshold) pending = true;
+    }
+    static void untrack(GcLink* link) {
+        if (!link->tracked) return;
+        Heap* h = heap;
+        if (link->prev) link->prev->next = link->next;
+        else h->head = link->next;
+        if (link->next) link->next->prev = link->prev;
+        link->prev = link->next = nullptr;
+        link->tracked = false;
+        h->count--;
+    }
+
+    // Between statements and on loop back edges: collects once the
+    // allocation threshold has been reached. An enclosing expression may
+    // still be building a container (a literal with a call in it); that is
+    // safe because the temporary holding it is a reference no tracked
+    // container accounts for, so trial deletion treats it as reachable.
+    static void safepoint() {
+        if (pending) collect();
+    }
+    static size_t collect();   // containers freed
+
+    static Stats stats();
+    static size_t tracked();    // live arrays and dicts in the list
+    static size_t threshold();  // allocations that trigger the next pass
+
+private:
+    // The next pass runs after as many allocations as there were containers
+    // left by the last one, so time spent collecting stays proportional
+    static constexpr size_t MIN_THRESHOLD = 10000;
+
+    struct Heap {
+        GcLink* head = nullptr;
+        size_t count = 0;
+        size_t allocations = 0;      // since the last collection
+        size_t threshold = MIN_THRESHOLD;
+        Stats stats;
+    };
+    static inline thread_local Heap* heap = nullptr;
+    static inline thread_local bool pending = false;
+};
@@ -1,5 +1,8 @@
 #pragma once
 #include "parser.h"
+#include "resolver.h"
+#include "value.h"
+#include <deque>
 #include <map>
 #include <set>
 #include <string>
@@ -34,84 +37,32 @@
   #define LANG_INVALID_SOCKET (-1)
 #endif
 
-// Forward declare dict type
-using Dict = std::map<std::string, struct Value>;
-
-struct Value {
-    enum class Type { NUMBER, STRING, BOOLEAN, ARRAY, DICT, NULL_TYPE } type;
-
-    double number = 0;
-    std::string string;
-    bool boolean = false;
-    std::shared_ptr<std::vector<Value>> array;
-    std::shared_ptr<Dict> dict;
-
-    Value() : type(Type::NULL_TYPE) {}  // default = Null
-    Value(double n) : type(Type::NUMBER), number(n) {}
-    Value(const std::string& s) : type(Type::STRING), string(s) {}
-    Value(bool b) : type(Type::BOOLEAN), boolean(b) {}
-    Value(std::shared_ptr<std::vector<Value>> a) : type(Type::ARRAY), array(a) {}
-    Value(std::shared_ptr<Dict> d) : type(Type::DICT), dict(d) {}
-
-    static Value make_null() { return Value(); }
-
-    bool is_number()  const { return type == Type::NUMBER; }
-    bool is_string()  const { return type == Type::STRING; }
-    bool is_boolean() const { return type == Type::BOOLEAN; }
-    bool is_array()   const { return type == Type::ARRAY; }
-    bool is_dict()    const { return type == Type::DICT; }
-    bool is_null()    const { return type == Type::NULL_TYPE; }
-
-    bool truthy() const {
-        if (is_null())    return false;
-        if (is_boolean()) return boolean;
-        if (is_number())  return number != 0;
-        if (is_string())  return !string.empty();
-        if (is_array())   return !array->empty();
-        if (is_dict())    return !dict->empty();
-        return false;
-    }
+// How a statement finished. Anything but NORMAL unwinds the enclosing blocks
+// up to the loop (BREAK, CONTINUE) or function call (RETURN) that handles it;
+// a RETURN leaves its value in Interpreter::return_value. TAIL_CALL is a
+// Return of a call to the running function: the arguments wait in
+// Interpreter::tail_args and the call rebinds its frame and reruns the body.
+enum class ExecStatus { NORMAL, BREAK, CONTINUE, RETURN, TAIL_CALL };
 
-    std::string to_string() const {
-        if (is_null())    return "Null";
-        if (is_string())  return string;
-        if (is_boolean()) return boolean ? "True" : "False";
-        if (is_array()) {
-            std::string s = "[";
-            for (size_t i = 0; i < array->size(); i++) {
-                s += (*array)[i].to_string();
-                if (i + 1 < array->size()) s += ", ";
-            }
-            return s + "]";
-        }
-        if (is_dict()) {
-            std::string s = "{";
-            bool first = true;
-            for (auto& [k, v] : *dict) {
-                if (!first) s += ", ";
-                s += "\"" + k + "\": " + v.to_string();
-                first = false;
-            }
-            return s + "}";
-        }
-        if (number == (int)number) return std::to_string((int)number);
-        return std::to_string(number);
-    }
-};
-
-struct ReturnException {
-    Value value;
-    ReturnException(Value v) : value(v) {}
-};
-
-struct BreakException {};
-struct ContinueException {};
+class VM;
+class Compiler;
+class Optimizer;
+class Jit;
+class Runtime;
 
 class Interpreter {
 public:
-    void execute(const std::vector<std::unique_ptr<ASTNode>>& statements);
+    // TREE walks the AST directly; VM compiles it to bytecode first (vm.h)
+    enum class Engine { TREE, VM };
+
+    Interpreter();
+    ~Interpreter();
+
+    void execute(std::vector<NodePtr>& statements, AstArena& arena);
     void import_file(const std::string& filepath);
     void set_current_dir(const std::string& dir) { current_dir = dir; }
+    void set_engine(Engine e) { engine = e; }
+    void set_constant_folding(bool on) { fold_constants = on; }
 
     // LANGPACK API — register a native function callable from LANGUAGE scripts
     // name: the function name as it appears in LANGUAGE code e.g. "QtCreateWindow"
@@ -119,15 +70,60 @@ public:
     using NativeFunction = std::function<Value(std::vector<Value>)>;
     void register_function(const std::string& name, NativeFunction fn) {
         native_functions[name] = fn;
+        call_generation++;
     }
 
 private:
+    friend class VM;
+    friend class Compiler;
+    friend class Optimizer;
+    friend class Jit;
+    friend class Runtime;
+
     std::string current_dir;
-    std::map<std::string, Value> variables;
+    Engine engine = Engine::TREE;
+    bool fold_constants = true;
+    std::unique_ptr<VM> vm;
+#if defined(USE_JIT)
+    std::unique_ptr<Jit> jit;
+#endif
+
+    // Variable scopes — top-level code lives in globals; every user function
+    // call pushes a CallFrame holding only its parameters and locals, so a
+    // call costs O(params) instead of copying every live variable.
+    // Slots are assigned ahead of time by the Resolver (see resolver.h).
+    struct VarSlot {
+        Value value;
+        bool defined = false;
+    };
+    struct CallFrame {
+        FuncDefNode* func = nullptr;
+        std::vector<VarSlot> locals;
+    };
+    GlobalTable global_table;
+    std::deque<VarSlot> globals;   // deque: growing on Import keeps slot addresses stable
+    std::vector<CallFrame> frames;
+
+    void prepare(std::vector<NodePtr>& program, AstArena& arena); // fold, resolve, fuse, size globals
+    void run_unit(const std::vector<NodePtr>& program); // on the selected engine
+    Value* find_variable(const VarRef& ref, const std::string& name);
+    Value& assign_variable(const VarRef& ref);
+    void check_arity(FuncDefNode* func, size_t argc);
+    void push_frame(FuncDefNode* func, std::vector<Value>& args);
+    void bind_params(FuncDefNode* func, std::vector<Value>& args); // resets the top frame
     std::map<std::string, FuncDefNode*> functions;
     std::map<std::string, NativeFunction> native_functions; // LANGPACK registered functions
+    // Bumped whenever either map above changes; FuncCallNode caches resolved
+    // against an older generation are redone on their next call
+    uint32_t call_generation = 1;
+    void resolve_call(FuncCallNode* call);
     std::set<std::string> imported_files;
-    std::vector<std::vector<std::unique_ptr<ASTNode>>> imported_asts;
+    // Imported files stay alive for the whole run: functions point into them
+    struct ImportedUnit {
+        std::unique_ptr<AstArena> arena;    // declared first, so freed last
+        std::vector<NodePtr> statements;
+    };
+    std::vector<ImportedUnit> imported_units;
 
     // TCP socket state
     std::map<int, lang_socket_t> tcp_sockets;   // handle -> fd
@@ -184,7 +180,35 @@ private:
 
     Value evaluate(ASTNode* node);
     bool evaluate_condition(ASTNode* node);
-    void execute_statement(ASTNode* node);
+    // Quickened operators (TypeFeedback in parser.h)
+    Value binary_op(BinaryOpNode* bin);
+    bool number_op(BinaryOpNode* bin, Value& boxed, double& out);
+    bool evaluate_number(ASTNode* node, Value& boxed, double& out);
+    // Borrowed reads: no copy for variables and their elements
+    const Value& evaluate_ref(ASTNode* node, Value& scratch);
+    static bool reads_only(ASTNode* node);
+    static const Value& lookup(const Value& container, const Value& key, const std::string& name,
+                               Value& scratch);
+    static void store(Value& container, const Value& key, Value value, const std::string& name);
+    static void push(const Value& arr, Value value);   // arr: an array or NumberArray
+    Value call_builtin(StringOpNode* op);
+    Value call_builtin(Builtin id, const Value& target, const std::vector<Value>& args);
+    void load_langpack(const std::string& name);
+    static Value read_input(const Value& prompt);
+    static Value read_file(const Value& path);
+    static void write_file(const Value& path, const Value& content, bool append);
+    static Value random_number();
+    static Value statistic(Builtin id, const Value& arr);   // Mean, Sum, Median, StdDev, Variance
+    ExecStatus execute_statement(ASTNode* node);
+    ExecStatus execute_block(const std::vector<NodePtr>& stmts);
+    [[noreturn]] static void outside_loop(ExecStatus status);
+    Value return_value;
+    std::vector<Value> tail_args;
+
+    static Value arithmetic(TokenType op, const Value& left, const Value& right);
+    static void append_to(Value& target, Value left, const Value& right);   // x = x + e
+    static bool compare(TokenType op, const Value& left, const Value& right);
+    static bool is_routed_call(const std::string& name); // FuncCallNode names evaluate() handles itself
 };
 
 // LangInterp is Interpreter — used by the C API in language_api.h
@@ -0,0 +1,655 @@
+#include "jit.h"
+#include "interpreter.h"
+#include <cstring>
+#include <sys/mman.h>
+
+JitCode::~JitCode() {
+    if (memory) munmap(memory, size);
+}
+
+namespace {
+
+// ── Frame layout ──────────────────────────────────────────────────────────
+// [rbp-8] saved rbx (the bail flag pointer), [rbp-16] saved r12 (depth),
+// then one double per value slot — the function's locals followed by a
+// counter/limit pair per For loop — then one "defined" word per local.
+// Temporaries go on the machine stack above that.
+constexpr int MAX_PARAMS = 16;
+
+enum Cond : uint8_t { JB = 0x2, JAE = 0x3, JE = 0x4, JNE = 0x5, JBE = 0x6, JA = 0x7, JP = 0xA };
+enum Arith : uint8_t { ADDSD = 0x58, MULSD = 0x59, SUBSD = 0x5C, DIVSD = 0x5E };
+
+class Codegen {
+public:
+    explicit Codegen(FuncDefNode* func)
+        : func(func), params((int)func->params.size()), locals(func->num_locals) {}
+
+    // Checks the body against the supported subset; fills self_call
+    bool supported();
+    std::vector<uint8_t> generate();
+
+    FuncCallNode* self_call = nullptr;
+
+private:
+    struct Label {
+        long pos = -1;
+        std::vector<size_t> uses;
+    };
+    struct Loop {
+        Label* exit;
+        Label* next;
+    };
+
+    FuncDefNode* func;
+    int params;
+    int locals;
+    int for_loops = 0;        // counted by supported(), numbered by generate()
+    int next_for = 0;
+    int pushed = 0;           // 8-byte temporaries currently on the stack
+    std::vector<uint8_t> out;
+    std::vector<Loop> loops;
+    Label bail, epilogue, body_start;
+
+    // ── Subset check ──
+    bool local_ok(const VarRef& ref) const { return ref.local && ref.slot >= 0 && ref.slot < locals; }
+    bool block_ok(const std::vector<NodePtr>& body, int depth);
+    bool stmt_ok(ASTNode* node, int depth);
+    bool expr_ok(ASTNode* node);
+    bool cond_ok(ASTNode* node);
+    bool self_call_ok(ASTNode* node);
+
+    // ── Emission ──
+    int value_slots() const { return locals + 2 * for_loops; }
+    int32_t value_disp(int slot) const { return -16 - 8 * (slot + 1); }
+    int32_t flag_disp(int slot) const { return -16 - 8 * value_slots() - 8 * (slot + 1); }
+
+    void emit(std::initializer_list<uint8_t> bytes) { out.insert(out.end(), bytes); }
+    void emit32(int32_t v) {
+        uint8_t b[4];
+        std::memcpy(b, &v, 4);
+        out.insert(out.end(), b, b + 4);
+    }
+    void emit64(uint64_t v) {
+        uint8_t b[8];
+        std::memcpy(b, &v, 8);
+        out.insert(out.end(), b, b + 8);
+    }
+    void bind(Label& l);
+    void jump(Label& l);
+    void jump_if(Cond cc, Label& l);
+    void target(Label& l);
+
+    void load_slot(int x, int slot) { emit({0xF2, 0x0F, 0x10, (uint8_t)(0x85 | x << 3)}); emit32(value_disp(slot)); }
+    void store_slot(int slot, int x) { emit({0xF2, 0x0F, 0x11, (uint8_t)(0x85 | x << 3)}); emit32(value_disp(slot)); }
+    void set_flag(int slot, int32_t v) { emit({0x48, 0xC7, 0x85}); emit32(flag_disp(slot)); emit32(v); }
+    void load_const(int x, double d);
+    void arith(Arith op, int dst, int src) { emit({0xF2, 0x0F, op, (uint8_t)(0xC0 | dst << 3 | src)}); }
+    void ucomisd(int a, int b) { emit({0x66, 0x0F, 0x2E, (uint8_t)(0xC0 | a << 3 | b)}); }
+    void push_xmm0();
+    void pop_xmm0();
+    void reserve_args(int& bytes);
+
+    void block(const std::vector<NodePtr>& body);
+    void statement(ASTNode* node);
+    void expression(ASTNode* node);         // result in xmm0
+    void variable(const VarRef& ref);
+    void branch(ASTNode* node, bool when, Label& to);
+    void compare_branch(TokenType op, bool when, Label& to);   // xmm0 op xmm1
+    void self_args(FuncCallNode* call, int& bytes);
+};
+
+// ── Subset check ──────────────────────────────────────────────────────────
+bool Codegen::supported() {
+    if (params > MAX_PARAMS) return false;
+    return block_ok(func->body, 0);
+}
+
+bool Codegen::block_ok(const std::vector<NodePtr>& body, int depth) {
+    for (const auto& stmt : body)
+        if (!stmt_ok(stmt.get(), depth)) return false;
+    return true;
+}
+
+bool Codegen::stmt_ok(ASTNode* node, int depth) {
+    switch (node->type) {
+        case NodeType::ASSIGNMENT: {
+            auto* n = static_cast<AssignmentNode*>(node);
+            return local_ok(n->ref) && expr_ok(n->value.get());
+        }
+        case NodeType::INCREMENT:
+            return local_ok(static_cast<IncrementNode*>(node)->ref);
+        case NodeType::APPEND: {
+            auto* n = static_cast<AppendNode*>(node);
+            return local_ok(n->ref) && expr_ok(n->value.get());
+        }
+        case NodeType::IF_STATEMENT: {
+            auto* n = static_cast<IfStatementNode*>(node);
+            if (!cond_ok(n->condition.get()) || !block_ok(n->body, depth)) return false;
+            for (auto& clause : n->elif_clauses)
+                if (!cond_ok(clause.condition.get()) || !block_ok(clause.body, depth)) return false;
+            return block_ok(n->else_body, depth);
+        }
+        case NodeType::WHILE_LOOP: {
+            auto* n = static_cast<WhileLoopNode*>(node);
+            return cond_ok(n->condition.get()) && block_ok(n->body, depth + 1);
+        }
+        case NodeType::FOR_LOOP: {
+            auto* n = static_cast<ForLoopNode*>(node);
+            for_loops++;
+            return local_ok(n->var_ref) && expr_ok(n->start.get()) && expr_ok(n->end.get()) &&
+                   block_ok(n->body, depth + 1);
+        }
+        case NodeType::BREAK_STATEMENT:
+        case NodeType::CONTINUE_STATEMENT:
+            return depth > 0;
+        case NodeType::RETURN_STATEMENT:
+            return expr_ok(static_cast<ReturnNode*>(node)->value.get());
+        default:
+            return false;
+    }
+}
+
+bool Codegen::expr_ok(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::NUMBER:
+            return true;
+        case NodeType::VARIABLE:
+            return local_ok(static_cast<VariableNode*>(node)->ref);
+        case NodeType::BINARY_OP: {
+            auto* n = static_cast<BinaryOpNode*>(node);
+            bool known = n->op == TokenType::PLUS || n->op == TokenType::MINUS ||
+                         n->op == TokenType::MULTIPLY || n->op == TokenType::DIVIDE;
+            return known && expr_ok(n->left.get()) && expr_ok(n->right.get());
+        }
+        case NodeType::FUNC_CALL:
+            return self_call_ok(node);
+        default:
+            return false;
+    }
+}
+
+bool Codegen::self_call_ok(ASTNode* node) {
+    auto* call = static_cast<FuncCallNode*>(node);
+    if (call->name != func->name || (int)call->args.size() != params) return false;
+    for (auto& arg : call->args)
+        if (!expr_ok(arg.get())) return false;
+    self_call = call;
+    return true;
+}
+
+static bool is_comparison(TokenType op) {
+    switch (op) {
+        case TokenType::EQUAL: case TokenType::NOT_EQUAL:
+        case TokenType::LESS_THAN: case TokenType::GREATER_THAN:
+        case TokenType::LESS_EQUAL: case TokenType::GREATER_EQUAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool Codegen::cond_ok(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::COMPARISON: {
+            auto* n = static_cast<ComparisonNode*>(node);
+            return is_comparison(n->op) && expr_ok(n->left.get()) && expr_ok(n->right.get());
+        }
+        case NodeType::COMPARE_CONST: {
+            auto* n = static_cast<CompareConstNode*>(node);
+            return is_comparison(n->op) && local_ok(n->ref) && n->constant.is_number();
+        }
+        case NodeType::LOGICAL_OP: {
+            auto* n = static_cast<LogicalOpNode*>(node);
+            return (n->op == TokenType::AND || n->op == TokenType::OR) &&
+                   cond_ok(n->left.get()) && cond_ok(n->right.get());
+        }
+        case NodeType::NOT_OP:
+            return cond_ok(static_cast<NotOpNode*>(node)->operand.get());
+        default:
+            return false;
+    }
+}
+
+// ── Emission helpers ──────────────────────────────────────────────────────
+void Codegen::bind(Label& l) {
+    l.pos = (long)out.size();
+    for (size_t use : l.uses) {
+        int32_t rel = (int32_t)(l.pos - (long)(use + 4));
+        std::memcpy(&out[use], &rel, 4);
+    }
+    l.uses.clear();
+}
+
+// rel32 operand of the jump just emitted
+void Codegen::target(Label& l) {
+    if (l.pos >= 0) {
+        emit32((int32_t)(l.pos - (long)(out.size() + 4)));
+    } else {
+        l.uses.push_back(out.size());
+        emit32(0);
+    }
+}
+
+void Codegen::jump(Label& l) {
+    emit({0xE9});
+    target(l);
+}
+
+void Codegen::jump_if(Cond cc, Label& l) {
+    emit({0x0F, (uint8_t)(0x80 | cc)});
+    target(l);
+}
+
+void Codegen::load_const(int x, double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, 8);
+    emit({0x48, 0xB8});                                   // mov rax, imm64
+    emit64(bits);
+    emit({0x66, 0x48, 0x0F, 0x6E, (uint8_t)(0xC0 | x << 3)});   // movq xmm, rax
+}
+
+void Codegen::push_xmm0() {
+    emit({0x48, 0x83, 0xEC, 0x08});             // sub rsp, 8
+    emit({0xF2, 0x0F, 0x11, 0x04, 0x24});       // movsd [rsp], xmm0
+    pushed++;
+}
+
+void Codegen::pop_xmm0() {
+    emit({0xF2, 0x0F, 0x10, 0x04, 0x24});       // movsd xmm0, [rsp]
+    emit({0x48, 0x83, 0xC4, 0x08});             // add rsp, 8
+    pushed--;
+}
+
+// Evaluates a self call's arguments into a fresh area at rsp, padded so
+// rsp stays 16-byte aligned for the call
+void Codegen::self_args(FuncCallNode* call, int& bytes) {
+    int slots = params + ((pushed + params) % 2);
+    bytes = 8 * slots;
+    emit({0x48, 0x81, 0xEC});                   // sub rsp, imm32
+    emit32(bytes);
+    pushed += slots;
+    for (int i = 0; i < params; i++) {
+        expression(call->args[i].get());
+        emit({0xF2, 0x0F, 0x11, 0x84, 0x24});   // movsd [rsp+disp32], xmm0
+        emit32(8 * i);
+    }
+}
+
+// ── Code generation ───────────────────────────────────────────────────────
+std::vector<uint8_t> Codegen::generate() {
+    int frame = 8 * (value_slots() + locals);
+    frame = (frame + 15) & ~15;
+
+    emit({0x55});                               // push rbp
+    emit({0x48, 0x89, 0xE5});                   // mov rbp, rsp
+    emit({0x53});                               // push rbx
+    emit({0x41, 0x54});                         // push r12
+    emit({0x48, 0x81, 0xEC});                   // sub rsp, frame
+    emit32(frame);
+    emit({0x48, 0x89, 0xD3});                   // mov rbx, rdx
+    emit({0x41, 0x89, 0xF4});                   // mov r12d, esi
+    emit({0x41, 0x81, 0xFC});                   // cmp r12d, MAX_DEPTH
+    emit32((int32_t)Jit::MAX_DEPTH);
+    jump_if(JAE, bail);
+    for (int i = 0; i < params; i++) {
+        emit({0xF2, 0x0F, 0x10, 0x87});         // movsd xmm0, [rdi+disp32]
+        emit32(8 * i);
+        store_slot(i, 0);
+    }
+    // A tail call re-enters here with the parameters already rebound
+    bind(body_start);
+    for (int i = params; i < locals; i++) set_flag(i, 0);
+
+    block(func->body);
+    // Falling off the end returns the interpreter's default value
+    jump(bail);
+
+    bind(bail);
+    emit({0xC7, 0x03, 0x01, 0x00, 0x00, 0x00}); // mov dword [rbx], 1
+    bind(epilogue);
+    emit({0x48, 0x8D, 0x65, 0xF0});             // lea rsp, [rbp-16]
+    emit({0x41, 0x5C});                         // pop r12
+    emit({0x5B});                               // pop rbx
+    emit({0x5D});                               // pop rbp
+    emit({0xC3});                               // ret
+    return std::move(out);
+}
+
+void Codegen::block(const std::vector<NodePtr>& body) {
+    for (const auto& stmt : body) statement(stmt.get());
+}
+
+void Codegen::statement(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::ASSIGNMENT: {
+            auto* n = static_cast<AssignmentNode*>(node);
+            expression(n->value.get());
+            store_slot(n->ref.slot, 0);
+            if (n->ref.slot >= params) set_flag(n->ref.slot, 1);
+            break;
+        }
+
+        case NodeType::INCREMENT: {
+            auto* n = static_cast<IncrementNode*>(node);
+            variable(n->ref);
+            load_const(1, n->amount);
+            arith(n->op == TokenType::PLUS ? ADDSD : SUBSD, 0, 1);
+            store_slot(n->ref.slot, 0);
+            break;
+        }
+
+        case NodeType::APPEND: {
+            auto* n = static_cast<AppendNode*>(node);
+            variable(n->ref);
+            push_xmm0();
+            expression(n->value.get());
+            emit({0x66, 0x0F, 0x28, 0xC8});     // movapd xmm1, xmm0
+            pop_xmm0();
+            arith(ADDSD, 0, 1);
+            store_slot(n->ref.slot, 0);
+            break;
+        }
+
+        case NodeType::IF_STATEMENT: {
+            auto* n = static_cast<IfStatementNode*>(node);
+            Label end, next;
+            branch(n->condition.get(), false, next);
+            block(n->body);
+            jump(end);
+            bind(next);
+            for (auto& clause : n->elif_clauses) {
+                Label after;
+                branch(clause.condition.get(), false, after);
+                block(clause.body);
+                jump(end);
+                bind(after);
+            }
+            block(n->else_body);
+            bind(end);
+            break;
+        }
+
+        case NodeType::WHILE_LOOP: {
+            auto* n = static_cast<WhileLoopNode*>(node);
+            Label top, exit;
+            bind(top);
+            branch(n->condition.get(), false, exit);
+            loops.push_back({&exit, &top});
+            block(n->body);
+            loops.pop_back();
+            jump(top);
+            bind(exit);
+            break;
+        }
+
+        case NodeType::FOR_LOOP: {
+            // Same shape as the tree walker: a private counter runs from start
+            // while it is <= end, and the variable is only written
+            auto* n = static_cast<ForLoopNode*>(node);
+            int counter = locals + 2 * next_for++;
+            int limit = counter + 1;
+            expression(n->start.get());
+            store_slot(counter, 0);
+            expression(n->end.get());
+            store_slot(limit, 0);
+            Label top, step, exit;
+            bind(top);
+            load_slot(0, limit);
+            emit({0x66, 0x0F, 0x2E, 0x85});     // ucomisd xmm0, [rbp+counter]
+            emit32(value_disp(counter));
+            jump_if(JB, exit);                  // limit < counter, or NaN
+            load_slot(0, counter);
+            store_slot(n->var_ref.slot, 0);
+            if (n->var_ref.slot >= params) set_flag(n->var_ref.slot, 1);
+            loops.push_back({&exit, &step});
+            block(n->body);
+            loops.pop_back();
+            bind(step);
+            load_slot(0, counter);
+            load_const(1, 1.0);
+            arith(ADDSD, 0, 1);
+            store_slot(counter, 0);
+            jump(top);
+            bind(exit);
+            break;
+        }
+
+        case NodeType::BREAK_STATEMENT:
+            jump(*loops.back().exit);
+            break;
+
+        case NodeType::CONTINUE_STATEMENT:
+            jump(*loops.back().next);
+            break;
+
+        case NodeType::RETURN_STATEMENT: {
+            auto* n = static_cast<ReturnNode*>(node);
+            if (n->tail_call) {
+                // Rebind the parameters and rerun the body in this frame
+                int bytes;
+                self_args(static_cast<FuncCallNode*>(n->value.get()), bytes);
+                for (int i = 0; i < params; i++) {
+                    emit({0xF2, 0x0F, 0x10, 0x84, 0x24});   // movsd xmm0, [rsp+disp32]
+                    emit32(8 * i);
+                    store_slot(i, 0);
+                }
+                emit({0x48, 0x81, 0xC4});               // add rsp, imm32
+                emit32(bytes);
+                pushed -= bytes / 8;
+                jump(body_start);
+                break;
+            }
+            expression(n->value.get());
+            jump(epilogue);
+            break;
+        }
+
+        default:
+            break;   // rejected by supported()
+    }
+}
+
+void Codegen::variable(const VarRef& ref) {
+    // Parameters are always bound; other locals may not be assigned yet, in
+    // which case the name would fall through to a global
+    if (ref.slot >= params) {
+        emit({0x48, 0x83, 0xBD});               // cmp qword [rbp+flag], 0
+        emit32(flag_disp(ref.slot));
+        emit({0x00});
+        jump_if(JE, bail);
+    }
+    load_slot(0, ref.slot);
+}
+
+void Codegen::expression(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::NUMBER:
+            load_const(0, static_cast<NumberNode*>(node)->value);
+            break;
+
+        case NodeType::VARIABLE:
+            variable(static_cast<VariableNode*>(node)->ref);
+            break;
+
+        case NodeType::BINARY_OP: {
+            auto* n = static_cast<BinaryOpNode*>(node);
+            expression(n->left.get());
+            push_xmm0();
+            expression(n->right.get());
+            emit({0x66, 0x0F, 0x28, 0xC8});     // movapd xmm1, xmm0
+            pop_xmm0();
+            switch (n->op) {
+                case TokenType::PLUS:     arith(ADDSD, 0, 1); break;
+                case TokenType::MINUS:    arith(SUBSD, 0, 1); break;
+                case TokenType::MULTIPLY: arith(MULSD, 0, 1); break;
+                default: {
+                    // Division by zero raises an error: leave that to the interpreter
+                    Label nonzero;
+                    emit({0x66, 0x0F, 0x57, 0xD2});     // xorpd xmm2, xmm2
+                    ucomisd(1, 2);
+                    jump_if(JP, nonzero);
+                    jump_if(JE, bail);
+                    bind(nonzero);
+                    arith(DIVSD, 0, 1);
+                    break;
+                }
+            }
+            break;
+        }
+
+        case NodeType::FUNC_CALL: {
+            int bytes;
+            self_args(static_cast<FuncCallNode*>(node), bytes);
+            emit({0x48, 0x89, 0xE7});                   // mov rdi, rsp
+            emit({0x41, 0x8D, 0x74, 0x24, 0x01});       // lea esi, [r12+1]
+            emit({0x48, 0x89, 0xDA});                   // mov rdx, rbx
+            emit({0xE8});                               // call <this function>
+            emit32(-(int32_t)(out.size() + 4));
+            emit({0x48, 0x81, 0xC4});                   // add rsp, imm32
+            emit32(bytes);
+            pushed -= bytes / 8;
+            emit({0x83, 0x3B, 0x00});                   // cmp dword [rbx], 0
+            jump_if(JNE, bail);
+            break;
+        }
+
+        default:
+            break;   // rejected by supported()
+    }
+}
+
+// Jumps to `to` when the condition evaluates to `when`, else falls through
+void Codegen::branch(ASTNode* node, bool when, Label& to) {
+    switch (node->type) {
+        case NodeType::COMPARISON: {
+            auto* n = static_cast<ComparisonNode*>(node);
+            expression(n->left.get());
+            push_xmm0();
+            expression(n->right.get());
+            emit({0x66, 0x0F, 0x28, 0xC8});     // movapd xmm1, xmm0
+            pop_xmm0();
+            compare_branch(n->op, when, to);
+            break;
+        }
+
+        case NodeType::COMPARE_CONST: {
+            auto* n = static_cast<CompareConstNode*>(node);
+            variable(n->ref);
+            load_const(1, n->constant.number());
+            compare_branch(n->op, when, to);
+            break;
+        }
+
+        case NodeType::LOGICAL_OP: {
+            auto* n = static_cast<LogicalOpNode*>(node);
+            // Short-circuit: the left side alone decides when it is false for
+            // And or true for Or
+            bool decides = n->op == TokenType::OR;
+            if (when == decides) {
+                branch(n->left.get(), when, to);
+                branch(n->right.get(), when, to);
+            } else {
+                Label skip;
+                branch(n->left.get(), decides, skip);
+                branch(n->right.get(), when, to);
+                bind(skip);
+            }
+            break;
+        }
+
+        case NodeType::NOT_OP:
+            branch(static_cast<NotOpNode*>(node)->operand.get(), !when, to);
+            break;
+
+        default:
+            break;   // rejected by supported()
+    }
+}
+
+// ucomisd reports NaN as unordered (ZF = PF = CF = 1); every jump below
+// treats that as false, matching the C++ comparisons in Interpreter::compare
+void Codegen::compare_branch(TokenType op, bool when, Label& to) {
+    switch (op) {
+        case TokenType::LESS_THAN:      ucomisd(1, 0); jump_if(when ? JA : JBE, to); break;
+        case TokenType::LESS_EQUAL:     ucomisd(1, 0); jump_if(when ? JAE : JB, to); break;
+        case TokenType::GREATER_THAN:   ucomisd(0, 1); jump_if(when ? JA : JBE, to); break;
+        case TokenType::GREATER_EQUAL:  ucomisd(0, 1); jump_if(when ? JAE : JB, to); break;
+        case TokenType::EQUAL:
+        case TokenType::NOT_EQUAL: {
+            ucomisd(0, 1);
+            if (when == (op == TokenType::EQUAL)) {     // jump if equal
+                Label skip;
+                jump_if(JP, skip);
+                jump_if(JE, to);
+                bind(skip);
+            } else {                                    // jump if not equal
+                jump_if(JP, to);
+                jump_if(JNE, to);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool bailed(JitCode& code) {
+    if (++code.bails >= Jit::MAX_BAILS) code.disabled = true;
+    return false;
+}
+
+} // namespace
+
+// ── Jit ───────────────────────────────────────────────────────────────────
+JitCode* Jit::compile(FuncDefNode* func) {
+    Codegen gen(func);
+    if (!gen.supported()) return nullptr;
+    std::vector<uint8_t> bytes = gen.generate();
+
+    void* memory = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+    std::memcpy(memory, bytes.data(), bytes.size());
+    if (mprotect(memory, bytes.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, bytes.size());
+        return nullptr;
+    }
+
+    auto jc = std::make_unique<JitCode>();
+    jc->memory = memory;
+    jc->size = bytes.size();
+    jc->entry = reinterpret_cast<JitCode::Entry>(memory);
+    jc->self_call = gen.self_call;
+    code.push_back(std::move(jc));
+    return code.back().get();
+}
+
+bool Jit::call(FuncDefNode* func, const std::vector<Value>& args, Value& result) {
+    if (!func->jit) {
+        if (func->call_count > THRESHOLD) return false;    // refused earlier
+        if (++func->call_count <= THRESHOLD) return false;
+        func->jit = compile(func);
+        if (!func->jit) return false;
+    }
+    JitCode& jc = *func->jit;
+    if (jc.disabled) return false;
+    // Omitted arguments take defaults, which only the interpreter evaluates
+    if (args.size() != func->params.size()) return false;
+
+    double argv[MAX_PARAMS];
+    for (size_t i = 0; i < args.size(); i++) {
+        if (!args[i].is_number()) return bailed(jc);
+        argv[i] = args[i].number();
+    }
+    // Recursive calls are compiled as direct calls: still the same function?
+    if (FuncCallNode* self = jc.self_call) {
+        if (self->cache_generation != interp.call_generation) interp.resolve_call(self);
+        if (self->target != FuncCallNode::Target::USER || self->func != func) return bailed(jc);
+    }
+
+    int bail = 0;
+    double r = jc.entry(argv, 0, &bail);
+    if (bail) return bailed(jc);
+    result = Value(r);
+    return true;
+}
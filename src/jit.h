@@ -0,0 +1,50 @@
+#pragma once
+#include "parser.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Interpreter;
+
+// Native code for one function. Signature of the generated entry point:
+// args holds one double per parameter, depth counts nested native calls and
+// *bail is set when the code gives up (a guard failed, or it would divide by
+// zero); the caller then reruns the call in the interpreter.
+struct JitCode {
+    using Entry = double (*)(const double* args, uint32_t depth, int* bail);
+
+    Entry entry = nullptr;
+    void* memory = nullptr;
+    size_t size = 0;
+    FuncCallNode* self_call = nullptr;   // any recursive call in the body, to recheck its target
+    uint32_t bails = 0;
+    bool disabled = false;               // bailed too often: stay in the interpreter
+
+    ~JitCode();
+};
+
+// Jit — optional baseline compiler (-DUSE_JIT, Linux x86-64). A Func that is
+// called THRESHOLD times is compiled to SSE2 code if its body only computes
+// with numbers: number literals, its own parameters and locals, + - * /,
+// comparisons, And/Or/Not, If/While/For/Break/Continue/Return and calls to
+// itself. Anything else (globals, strings, built-ins, other functions) keeps
+// it in the interpreter. Compiled code touches nothing but its own frame, so
+// a bail anywhere can simply rerun the whole call.
+class Jit {
+public:
+    static constexpr uint32_t THRESHOLD = 50;   // calls before compiling
+    static constexpr uint32_t MAX_BAILS = 16;   // bails before giving up
+    static constexpr uint32_t MAX_DEPTH = 10000;
+
+    explicit Jit(Interpreter& interp) : interp(interp) {}
+
+    // Runs func natively if it is (or just became) compiled and every guard
+    // holds; false means the caller must run it in the interpreter
+    bool call(FuncDefNode* func, const std::vector<Value>& args, Value& result);
+
+private:
+    Interpreter& interp;
+    std::vector<std::unique_ptr<JitCode>> code;
+
+    JitCode* compile(FuncDefNode* func);
+};
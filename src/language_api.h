@@ -113,10 +113,17 @@ LANGPACK_EXPORT double       lang_to_number(LangValue* v);
 LANGPACK_EXPORT const char*  lang_to_string(LangValue* v); // do NOT free this pointer
 LANGPACK_EXPORT int          lang_to_bool(LangValue* v);   // 1 = true, 0 = false
 
-// Array helpers
+// Array helpers (also work on a NumberArray)
 LANGPACK_EXPORT int          lang_array_len(LangValue* v);
 LANGPACK_EXPORT LangValue*   lang_array_get(LangValue* v, int index);
 
+// NumberArray helpers. lang_is_array and lang_type treat a NumberArray as
+// an array; its numbers are one contiguous buffer of doubles, which
+// lang_number_array_data returns without copying. The pointer may be read
+// and written in place, and stays valid until the array is resized.
+LANGPACK_EXPORT int          lang_is_number_array(LangValue* v);
+LANGPACK_EXPORT double*      lang_number_array_data(LangValue* v);   // NULL if not a NumberArray
+
 // Dict helpers
 LANGPACK_EXPORT LangValue*   lang_dict_get(LangValue* v, const char* key);  // NULL if missing
 LANGPACK_EXPORT int          lang_dict_has(LangValue* v, const char* key);  // 1 if exists
@@ -127,10 +134,19 @@ LANGPACK_EXPORT LangValue*   lang_string(const char* s);
 LANGPACK_EXPORT LangValue*   lang_bool(int b);       // 1 = true, 0 = false
 LANGPACK_EXPORT LangValue*   lang_null(void);
 LANGPACK_EXPORT LangValue*   lang_array_new(void);
-LANGPACK_EXPORT void         lang_array_push(LangValue* arr, LangValue* v);
+LANGPACK_EXPORT void         lang_array_push(LangValue* arr, LangValue* v);   // numbers only for a NumberArray
+LANGPACK_EXPORT LangValue*   lang_number_array_new(int n);                    // n zeros
 LANGPACK_EXPORT LangValue*   lang_dict_new(void);
 LANGPACK_EXPORT void         lang_dict_set(LangValue* dict, const char* key, LangValue* v);
 
+// ── Threads ───────────────────────────────────────────────────────────────────
+// Values are reference counted without atomic operations. If your LANGPACK
+// keeps a value (or anything read out of it) on another thread, call this
+// on it first, on the thread that has it now. It covers everything the
+// value contains at that point; two threads must still not modify the same
+// array or dict at once.
+LANGPACK_EXPORT void         lang_share(LangValue* v);
+
 // ── Throw an error from your function ────────────────────────────────────────
 // This works like throw in LANGUAGE — can be caught with Try/Catch
 LANGPACK_EXPORT void         lang_error(LangInterp* interp, const char* message);
@@ -6,6 +6,7 @@
 #include "lexer.h"
 #include "parser.h"
 #include "interpreter.h"
+#include "transpiler.h"
 
 // Platform includes for update (download + replace)
 #ifdef _WIN32
@@ -46,6 +47,10 @@ void print_help() {
     std::cout << "\n";
     std::cout << "  USAGE\n";
     std::cout << "    LANGUAGE <script.LANGUAGE>       Run a script\n";
+    std::cout << "    LANGUAGE --engine=vm <script>    Run a script on the bytecode VM\n";
+    std::cout << "    LANGUAGE --no-fold <script>      Run without constant folding (debugging)\n";
+    std::cout << "    LANGUAGE --emit-cpp <script> [out.cpp]\n";
+    std::cout << "                                     Translate a script to C++ for language_runtime\n";
     std::cout << "    LANGUAGE --help                  Show this help message\n";
     std::cout << "    LANGUAGE --version               Show version\n";
     std::cout << "    LANGUAGE --update                Check for updates and install if available\n";
@@ -818,19 +823,85 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    if (arg == "--emit-cpp") {
+        if (argc < 3) {
+            std::cout << "  Usage: LANGUAGE --emit-cpp <script> [out.cpp]\n";
+#ifdef _WIN32
+            WSACleanup();
+#endif
+            return 1;
+        }
+        try {
+            Transpiler transpiler(argv[2]);
+            std::ostringstream code;
+            transpiler.emit(code);
+            if (argc >= 4) {
+                std::ofstream out(argv[3], std::ios::binary);
+                if (!out.is_open())
+                    throw std::runtime_error(std::string("Could not write file: ") + argv[3]);
+                out << code.str();
+            } else {
+                std::cout << code.str();
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+#ifdef _WIN32
+            WSACleanup();
+#endif
+            return 1;
+        }
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return 0;
+    }
+
+    // Run options come before the script path
+    Interpreter::Engine engine = Interpreter::Engine::TREE;
+    bool fold_constants = true;
+    int script_index = 1;
+    for (; script_index < argc; script_index++) {
+        std::string opt = argv[script_index];
+        if (opt.rfind("--", 0) != 0) break;
+        if (opt == "--engine=vm") {
+            engine = Interpreter::Engine::VM;
+        } else if (opt == "--engine=tree") {
+            engine = Interpreter::Engine::TREE;
+        } else if (opt == "--no-fold") {
+            fold_constants = false;
+        } else {
+            std::cerr << "Error: Unknown option: " << opt << "\n";
+#ifdef _WIN32
+            WSACleanup();
+#endif
+            return 1;
+        }
+    }
+    if (script_index >= argc) {
+        print_help();
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return 1;
+    }
+    arg = argv[script_index];
+
     try {
         std::string source = read_file(arg);
 
         Lexer lexer(source);
         auto tokens = lexer.tokenize();
 
-        Parser parser(tokens);
+        AstArena arena;
+        Parser parser(tokens, arena);
         auto ast = parser.parse();
 
         Interpreter interpreter;
         std::string script_dir = std::filesystem::weakly_canonical(arg).parent_path().string();
         interpreter.set_current_dir(script_dir);
-        interpreter.execute(ast);
+        interpreter.set_engine(engine);
+        interpreter.set_constant_folding(fold_constants);
+        interpreter.execute(ast, arena);
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
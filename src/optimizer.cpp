@@ -0,0 +1,219 @@
+#include "optimizer.h"
+#include "interpreter.h"
+
+static bool is_literal(const ASTNode* node) {
+    switch (node->type) {
+        case NodeType::NUMBER:
+        case NodeType::STRING:
+        case NodeType::BOOLEAN:
+        case NodeType::NULL_LITERAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static Value literal_value(const ASTNode* node) {
+    switch (node->type) {
+        case NodeType::NUMBER:  return Value(static_cast<const NumberNode*>(node)->value);
+        case NodeType::STRING:  return static_cast<const StringNode*>(node)->value;
+        case NodeType::BOOLEAN: return Value(static_cast<const BooleanNode*>(node)->value);
+        default:                return Value::make_null();
+    }
+}
+
+// Arrays and dicts are mutable, so only scalars become literals
+static NodePtr make_literal(AstArena& arena, const Value& v) {
+    if (v.is_number())  return arena.make<NumberNode>(v.number());
+    if (v.is_string())  return arena.make<StringNode>(v.str());
+    if (v.is_boolean()) return arena.make<BooleanNode>(v.boolean());
+    if (v.is_null())    return arena.make<NullNode>();
+    return nullptr;
+}
+
+void Optimizer::fold(const std::vector<NodePtr>& program) {
+    // Statements themselves are never constants; only their operands fold
+    for (const auto& stmt : program) {
+        visit_children(stmt.get(), [&](NodePtr& child) { fold_node(child); });
+        fold_conditions(stmt.get());
+    }
+}
+
+void Optimizer::fold_node(NodePtr& node) {
+    visit_children(node.get(), [&](NodePtr& child) { fold_node(child); });
+    fold_conditions(node.get());
+    if (auto folded = evaluate_constant(node.get()))
+        node = std::move(folded);
+}
+
+// Comparisons are only accepted as conditions (If/Elif/While and the
+// operands of And/Or/Not), so only those fold; anywhere else the node stays
+// to fail at run time as it would unfolded
+void Optimizer::fold_conditions(ASTNode* node) {
+    auto fold_comparison = [&](NodePtr& cond) {
+        if (!cond || cond->type != NodeType::COMPARISON) return;
+        auto* cmp = static_cast<ComparisonNode*>(cond.get());
+        if (!is_literal(cmp->left.get()) || !is_literal(cmp->right.get())) return;
+        try {
+            cond = make_literal(arena, Value(Interpreter::compare(cmp->op, literal_value(cmp->left.get()),
+                                                                  literal_value(cmp->right.get()))));
+        } catch (const std::exception&) {
+        }
+    };
+    switch (node->type) {
+        case NodeType::IF_STATEMENT: {
+            auto* n = static_cast<IfStatementNode*>(node);
+            fold_comparison(n->condition);
+            for (auto& clause : n->elif_clauses) fold_comparison(clause.condition);
+            break;
+        }
+        case NodeType::WHILE_LOOP:
+            fold_comparison(static_cast<WhileLoopNode*>(node)->condition);
+            break;
+        case NodeType::LOGICAL_OP: {
+            auto* n = static_cast<LogicalOpNode*>(node);
+            fold_comparison(n->left);
+            fold_comparison(n->right);
+            break;
+        }
+        case NodeType::NOT_OP:
+            fold_comparison(static_cast<NotOpNode*>(node)->operand);
+            break;
+        default:
+            break;
+    }
+}
+
+NodePtr Optimizer::evaluate_constant(ASTNode* node) {
+    try {
+        switch (node->type) {
+            case NodeType::BINARY_OP: {
+                // Includes unary minus, which the parser builds as 0 - x
+                auto* bin = static_cast<BinaryOpNode*>(node);
+                if (!is_literal(bin->left.get()) || !is_literal(bin->right.get())) return nullptr;
+                return make_literal(arena, Interpreter::arithmetic(bin->op, literal_value(bin->left.get()),
+                                                            literal_value(bin->right.get())));
+            }
+            case NodeType::LOGICAL_OP: {
+                // A literal left side that decides the result folds even when
+                // the right side doesn't: it would never have been evaluated
+                auto* log = static_cast<LogicalOpNode*>(node);
+                if (log->op != TokenType::AND && log->op != TokenType::OR) return nullptr;
+                if (!is_literal(log->left.get())) return nullptr;
+                bool left = literal_value(log->left.get()).truthy();
+                if (log->op == TokenType::AND && !left) return make_literal(arena, Value(false));
+                if (log->op == TokenType::OR && left)   return make_literal(arena, Value(true));
+                if (!is_literal(log->right.get())) return nullptr;
+                return make_literal(arena, Value(literal_value(log->right.get()).truthy()));
+            }
+            case NodeType::NOT_OP: {
+                auto* not_node = static_cast<NotOpNode*>(node);
+                if (!is_literal(not_node->operand.get())) return nullptr;
+                return make_literal(arena, Value(!literal_value(not_node->operand.get()).truthy()));
+            }
+            case NodeType::STRING_OP: {
+                auto* op = static_cast<StringOpNode*>(node);
+                if (!(builtin_info(op->id).flags & BUILTIN_PURE)) return nullptr;
+                if (op->target && !is_literal(op->target.get())) return nullptr;
+                for (auto& arg : op->args)
+                    if (!is_literal(arg.get())) return nullptr;
+                return make_literal(arena, interp.call_builtin(op));
+            }
+            default:
+                return nullptr;
+        }
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+// ── Superinstructions ─────────────────────────────────────────────────────
+static TokenType flip_comparison(TokenType op) {
+    switch (op) {
+        case TokenType::LESS_THAN:     return TokenType::GREATER_THAN;
+        case TokenType::GREATER_THAN:  return TokenType::LESS_THAN;
+        case TokenType::LESS_EQUAL:    return TokenType::GREATER_EQUAL;
+        case TokenType::GREATER_EQUAL: return TokenType::LESS_EQUAL;
+        default:                       return op;   // == and != are symmetric
+    }
+}
+
+void Optimizer::fuse(std::vector<NodePtr>& program) {
+    for (auto& stmt : program)
+        fuse_node(stmt);
+}
+
+void Optimizer::fuse_node(NodePtr& node) {
+    visit_children(node.get(), [&](NodePtr& child) { fuse_node(child); });
+    fuse_conditions(node.get());
+    if (auto replacement = fused(node.get()))
+        node = std::move(replacement);
+}
+
+// var <cmp> literal becomes a CompareConstNode only as a condition, the one
+// place a comparison is accepted; elsewhere it stays to fail at run time
+void Optimizer::fuse_conditions(ASTNode* node) {
+    auto fuse_comparison = [&](NodePtr& cond) {
+        if (!cond || cond->type != NodeType::COMPARISON) return;
+        auto* cmp = static_cast<ComparisonNode*>(cond.get());
+        ASTNode* left = cmp->left.get();
+        ASTNode* right = cmp->right.get();
+        if (left->type == NodeType::VARIABLE && is_literal(right)) {
+            auto* var = static_cast<VariableNode*>(left);
+            cond = arena.make<CompareConstNode>(cmp->op, var->name, var->ref, literal_value(right));
+        } else if (is_literal(left) && right->type == NodeType::VARIABLE) {
+            auto* var = static_cast<VariableNode*>(right);
+            cond = arena.make<CompareConstNode>(flip_comparison(cmp->op), var->name, var->ref,
+                                                literal_value(left));
+        }
+    };
+    switch (node->type) {
+        case NodeType::IF_STATEMENT: {
+            auto* n = static_cast<IfStatementNode*>(node);
+            fuse_comparison(n->condition);
+            for (auto& clause : n->elif_clauses) fuse_comparison(clause.condition);
+            break;
+        }
+        case NodeType::WHILE_LOOP:
+            fuse_comparison(static_cast<WhileLoopNode*>(node)->condition);
+            break;
+        case NodeType::LOGICAL_OP: {
+            auto* n = static_cast<LogicalOpNode*>(node);
+            fuse_comparison(n->left);
+            fuse_comparison(n->right);
+            break;
+        }
+        case NodeType::NOT_OP:
+            fuse_comparison(static_cast<NotOpNode*>(node)->operand);
+            break;
+        default:
+            break;
+    }
+}
+
+NodePtr Optimizer::fused(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::ASSIGNMENT: {
+            auto* assign = static_cast<AssignmentNode*>(node);
+            if (assign->value->type != NodeType::BINARY_OP) return nullptr;
+            auto* bin = static_cast<BinaryOpNode*>(assign->value.get());
+            if (bin->op != TokenType::PLUS && bin->op != TokenType::MINUS) return nullptr;
+            if (bin->left->type != NodeType::VARIABLE) return nullptr;
+            auto* var = static_cast<VariableNode*>(bin->left.get());
+            if (var->name != assign->var_name) return nullptr;
+            if (bin->right->type == NodeType::NUMBER)
+                return arena.make<IncrementNode>(assign->var_name, assign->ref, bin->op,
+                                                 static_cast<NumberNode*>(bin->right.get())->value);
+            if (bin->op != TokenType::PLUS) return nullptr;
+            return arena.make<AppendNode>(assign->var_name, assign->ref, std::move(bin->right));
+        }
+        case NodeType::DICT_ACCESS: {
+            auto* da = static_cast<DictAccessNode*>(node);
+            if (da->key->type != NodeType::VARIABLE) return nullptr;
+            auto* index = static_cast<VariableNode*>(da->key.get());
+            return arena.make<IndexVarNode>(da->name, da->ref, index->name, index->ref);
+        }
+        default:
+            return nullptr;
+    }
+}
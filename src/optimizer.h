@@ -0,0 +1,44 @@
+#pragma once
+#include "parser.h"
+#include <memory>
+#include <vector>
+
+class Interpreter;
+
+// Optimizer — AST rewrites around the Resolver.
+//
+// fold: constant folding, run after parsing and before the Resolver.
+// Operators, logical ops and pure built-ins (BUILTIN_PURE) whose operands are
+// all literals are evaluated once and replaced by a literal node, bottom-up,
+// so `2 * 3.14159 / 180`, `-1` and `Sqrt(144)` cost nothing at run time.
+// Comparisons of literals fold only where a condition is expected.
+// Folding goes through the interpreter's own operator and built-in code, so
+// results match an unfolded run; anything that would throw is left in place
+// to fail at run time as before. Disabled with --no-fold.
+//
+// fuse: run after the Resolver, for the tree engine only (the VM compiles
+// these shapes to short opcode sequences already). Replaces
+//   x = x + 1 / x = x - 1   (number literal)   → IncrementNode
+//   x = x + e                                  → AppendNode
+//   name[var]                                  → IndexVarNode
+//   var <cmp> literal / literal <cmp> var      → CompareConstNode
+//     (as a condition only: If/Elif/While, And/Or/Not operands)
+// with fused nodes copying the resolved slots, see parser.h.
+class Optimizer {
+public:
+    // Folded literals are allocated from the unit's own arena
+    Optimizer(Interpreter& interp, AstArena& arena) : interp(interp), arena(arena) {}
+    void fold(const std::vector<NodePtr>& program);
+    void fuse(std::vector<NodePtr>& program);
+
+private:
+    Interpreter& interp;
+    AstArena& arena;
+
+    void fold_node(NodePtr& node);
+    void fold_conditions(ASTNode* node);
+    NodePtr evaluate_constant(ASTNode* node);   // nullptr if not constant
+    void fuse_node(NodePtr& node);
+    void fuse_conditions(ASTNode* node);
+    NodePtr fused(ASTNode* node);               // nullptr if no pattern matches
+};
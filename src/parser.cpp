@@ -1,8 +1,25 @@
 #include "parser.h"
+#include <cstdint>
 #include <stdexcept>
 
-Parser::Parser(const std::vector<Token>& tokens)
-    : tokens(tokens), pos(0), current_token(tokens[0]) {}
+void* AstArena::allocate(size_t size, size_t align) {
+    size_t pad = (align - (reinterpret_cast<uintptr_t>(next) & (align - 1))) & (align - 1);
+    if (pad + size > remaining) {
+        // Oversized nodes get a block of their own; fresh blocks are max-aligned
+        size_t block = size > BLOCK_SIZE ? size : BLOCK_SIZE;
+        blocks.emplace_back(new char[block]);
+        next = blocks.back().get();
+        remaining = block;
+        pad = 0;
+    }
+    void* mem = next + pad;
+    next += pad + size;
+    remaining -= pad + size;
+    return mem;
+}
+
+Parser::Parser(const std::vector<Token>& tokens, AstArena& arena)
+    : arena(arena), tokens(tokens), pos(0), current_token(tokens[0]) {}
 
 void Parser::advance() {
     pos++;
@@ -13,8 +30,8 @@ void Parser::consume_newlines() {
     while (current_token.type == TokenType::NEWLINE) advance();
 }
 
-std::vector<std::unique_ptr<ASTNode>> Parser::parse_block() {
-    std::vector<std::unique_ptr<ASTNode>> stmts;
+std::vector<NodePtr> Parser::parse_block() {
+    std::vector<NodePtr> stmts;
     if (current_token.type != TokenType::INDENT)
         throw std::runtime_error("Expected indented block on line " + std::to_string(current_token.line));
     advance();
@@ -34,12 +51,12 @@ std::vector<std::unique_ptr<ASTNode>> Parser::parse_block() {
     return stmts;
 }
 
-std::unique_ptr<ASTNode> Parser::factor() {
+NodePtr Parser::factor() {
     Token token = current_token;
 
     if (token.type == TokenType::NUMBER) {
         advance();
-        return std::make_unique<NumberNode>(std::stod(token.value));
+        return arena.make<NumberNode>(std::stod(token.value));
     }
     if (token.type == TokenType::STRING) {
         advance();
@@ -47,19 +64,19 @@ std::unique_ptr<ASTNode> Parser::factor() {
         const std::string& raw = token.value;
         if (raw.find('{') != std::string::npos)
             return parse_interp_string(raw);
-        return std::make_unique<StringNode>(raw);
+        return arena.make<StringNode>(raw);
     }
     if (token.type == TokenType::TRUE) {
         advance();
-        return std::make_unique<BooleanNode>(true);
+        return arena.make<BooleanNode>(true);
     }
     if (token.type == TokenType::FALSE) {
         advance();
-        return std::make_unique<BooleanNode>(false);
+        return arena.make<BooleanNode>(false);
     }
     if (token.type == TokenType::NULL_TOKEN) {
         advance();
-        return std::make_unique<NullNode>();
+        return arena.make<NullNode>();
     }
     if (token.type == TokenType::LBRACE) {
         advance();
@@ -67,28 +84,28 @@ std::unique_ptr<ASTNode> Parser::factor() {
     }
     if (token.type == TokenType::NOT) {
         advance();
-        return std::make_unique<NotOpNode>(logical());
+        return arena.make<NotOpNode>(logical());
     }
     if (token.type == TokenType::MINUS) {
         advance();
         // Unary minus: wrap as 0 - factor
-        return std::make_unique<BinaryOpNode>(TokenType::MINUS,
-            std::make_unique<NumberNode>(0.0), factor());
+        return arena.make<BinaryOpNode>(TokenType::MINUS,
+            arena.make<NumberNode>(0.0), factor());
     }
     if (token.type == TokenType::INPUT) {
         advance();
         if (current_token.type != TokenType::LPAREN)
             throw std::runtime_error("Expected '(' after Input");
         advance();
-        std::unique_ptr<ASTNode> prompt;
+        NodePtr prompt;
         if (current_token.type != TokenType::RPAREN)
             prompt = logical();
         else
-            prompt = std::make_unique<StringNode>("");
+            prompt = arena.make<StringNode>("");
         if (current_token.type != TokenType::RPAREN)
             throw std::runtime_error("Expected ')' after Input prompt");
         advance();
-        return std::make_unique<InputNode>(std::move(prompt));
+        return arena.make<InputNode>(std::move(prompt));
     }
     
     if (token.type == TokenType::READFILE) {
@@ -100,12 +117,12 @@ std::unique_ptr<ASTNode> Parser::factor() {
         if (current_token.type != TokenType::RPAREN)
             throw std::runtime_error("Expected ')' after ReadFile");
         advance();
-        return std::make_unique<ReadFileNode>(std::move(path));
+        return arena.make<ReadFileNode>(std::move(path));
     }
     
     if (token.type == TokenType::LBRACKET) {
         advance();
-        std::vector<std::unique_ptr<ASTNode>> elements;
+        std::vector<NodePtr> elements;
         while (current_token.type != TokenType::RBRACKET && current_token.type != TokenType::END_OF_FILE) {
             elements.push_back(logical());
             if (current_token.type == TokenType::COMMA) advance();
@@ -113,7 +130,7 @@ std::unique_ptr<ASTNode> Parser::factor() {
         if (current_token.type != TokenType::RBRACKET)
             throw std::runtime_error("Expected ']' after array elements");
         advance();
-        return std::make_unique<ArrayNode>(std::move(elements));
+        return arena.make<ArrayNode>(std::move(elements));
     }
     if (token.type == TokenType::IDENTIFIER) {
         advance();
@@ -125,12 +142,12 @@ std::unique_ptr<ASTNode> Parser::factor() {
                 throw std::runtime_error("Expected ']' after index");
             advance();
             // Could be array or dict access — interpreter handles both
-            return std::make_unique<DictAccessNode>(token.value, std::move(index));
+            return arena.make<DictAccessNode>(token.value, std::move(index));
         }
 
         if (current_token.type == TokenType::LPAREN) {
             advance();
-            std::vector<std::unique_ptr<ASTNode>> args;
+            std::vector<NodePtr> args;
             while (current_token.type != TokenType::RPAREN && current_token.type != TokenType::END_OF_FILE) {
                 args.push_back(logical());
                 if (current_token.type == TokenType::COMMA) advance();
@@ -139,146 +156,56 @@ std::unique_ptr<ASTNode> Parser::factor() {
                 throw std::runtime_error("Expected ')' after arguments");
             advance();
 
-            if (token.value == "Length")    return std::make_unique<StringOpNode>("Length",    std::move(args[0]), std::vector<std::unique_ptr<ASTNode>>{});
-            if (token.value == "Upper")     return std::make_unique<StringOpNode>("Upper",     std::move(args[0]), std::vector<std::unique_ptr<ASTNode>>{});
-            if (token.value == "Lower")     return std::make_unique<StringOpNode>("Lower",     std::move(args[0]), std::vector<std::unique_ptr<ASTNode>>{});
-            if (token.value == "Push")      return std::make_unique<StringOpNode>("Push",      std::move(args[0]), [&]{ std::vector<std::unique_ptr<ASTNode>> r; r.push_back(std::move(args[1])); return r; }());
-            if (token.value == "Pop")       return std::make_unique<StringOpNode>("Pop",       std::move(args[0]), std::vector<std::unique_ptr<ASTNode>>{});
-            if (token.value == "Contains") {
-                auto target = std::move(args[0]);
-                std::vector<std::unique_ptr<ASTNode>> rest;
-                for (size_t i = 1; i < args.size(); i++) rest.push_back(std::move(args[i]));
-                return std::make_unique<StringOpNode>("Contains", std::move(target), std::move(rest));
-            }
-            if (token.value == "Substring") {
-                auto target = std::move(args[0]);
-                std::vector<std::unique_ptr<ASTNode>> rest;
-                for (size_t i = 1; i < args.size(); i++) rest.push_back(std::move(args[i]));
-                return std::make_unique<StringOpNode>("Substring", std::move(target), std::move(rest));
-            }
-
-            // Math built-ins (single argument or with extra args)
-            if (token.value == "Floor" || token.value == "Ceil" || token.value == "Round" ||
-                token.value == "Sqrt"  || token.value == "Abs"  || token.value == "Power" ||
-                token.value == "Sin"   || token.value == "Cos"  || token.value == "Tan" ||
-                token.value == "Asin"  || token.value == "Acos" || token.value == "Atan" ||
-                token.value == "Atan2" || token.value == "Mod"  || token.value == "Min" ||
-                token.value == "Max"   || token.value == "Clamp" || token.value == "Lerp" ||
-                token.value == "Log"   || token.value == "Log10" || token.value == "Log2" ||
-                token.value == "Exp"   || token.value == "Sinh"  || token.value == "Cosh" ||
-                token.value == "Tanh"  || token.value == "Asinh" || token.value == "Acosh" ||
-                token.value == "Atanh" || token.value == "Deg2Rad" || token.value == "Rad2Deg" ||
-                token.value == "Factorial" || token.value == "IsPrime" || token.value == "GCD" ||
-                token.value == "LCM"   || token.value == "RandomInt" ||
-                // Possibly useful
-                token.value == "Sign"    || token.value == "Truncate"  || token.value == "Frac" ||
-                token.value == "Hypot"   || token.value == "Cbrt"      || token.value == "CopySign" ||
-                token.value == "LogBase" ||
-                // Number checks
-                token.value == "IsNaN"   || token.value == "IsInf" ||
-                token.value == "IsEven"  || token.value == "IsOdd" ||
-                // Type checks
-                token.value == "IsNull"   || token.value == "IsDict"   ||
-                token.value == "IsArray"  || token.value == "IsString" ||
-                token.value == "IsNumber" || token.value == "IsBool"   ||
-                // Dictionary operations
-                token.value == "DictKeys"   || token.value == "DictValues" ||
-                token.value == "DictHas"    || token.value == "DictRemove" ||
-                token.value == "DictSize"   || token.value == "DictMerge"  ||
-                // JSON
-                token.value == "JsonParse"  || token.value == "JsonStringify" ||
-                // Bitwise
-                token.value == "BitAnd"  || token.value == "BitOr"         || token.value == "BitXor" ||
-                token.value == "BitNot"  || token.value == "BitShiftLeft"  || token.value == "BitShiftRight" ||
-                // Statistics
-                token.value == "Sum"     || token.value == "Product"  || token.value == "Mean" ||
-                token.value == "Median"  || token.value == "Variance" || token.value == "StdDev" ||
-                // Pure math
-                token.value == "Gamma"   || token.value == "Beta" ||
-                token.value == "Erf"     || token.value == "Erfc" ||
-                // TCP Sockets
-                token.value == "SocketConnect"     || token.value == "SocketListen" ||
-                token.value == "SocketAccept"      || token.value == "SocketSend" ||
-                token.value == "SocketReceive"     || token.value == "SocketReceiveLine" ||
-                token.value == "SocketClose"       || token.value == "SocketIsValid" ||
-                token.value == "SocketSetTimeout"  ||
-                // HTTP Server
-                token.value == "HttpServerCreate"  || token.value == "HttpServerAccept" ||
-                token.value == "HttpServerClose"   || token.value == "HttpConnClose" ||
-                token.value == "HttpRequestMethod" || token.value == "HttpRequestPath" ||
-                token.value == "HttpRequestBody"   || token.value == "HttpRequestHeader" ||
-                token.value == "HttpRequestParam"  ||
-                token.value == "HttpRespond"       || token.value == "HttpRespondFile" ||
-                // DNS
-                token.value == "DnsResolve"        || token.value == "DnsResolveAll" ||
-                token.value == "DnsResolveIPv6"    || token.value == "DnsReverse" ||
-                // HTTP client
-                token.value == "HttpGet"           || token.value == "HttpPost" ||
-                token.value == "HttpPut"           || token.value == "HttpDelete" ||
-                token.value == "HttpStatusCode"    || token.value == "HttpHeaders" ||
-                token.value == "HttpRequest"       || token.value == "HttpRequestStatus" ||
-                token.value == "HttpDownload"      || token.value == "HttpGetJson" ||
-                token.value == "HttpPostJson"      || token.value == "HttpGetWithTimeout" ||
-                token.value == "HttpGetFull"       ||
-                // HTTP server
-                token.value == "HttpServerCreate"  || token.value == "HttpServerAccept" ||
-                token.value == "HttpServerClose"   || token.value == "HttpConnClose" ||
-                token.value == "HttpRequestMethod" || token.value == "HttpRequestPath" ||
-                token.value == "HttpRequestBody"   || token.value == "HttpRequestHeader" ||
-                token.value == "HttpRequestParam"  || token.value == "HttpRequestQuery" ||
-                token.value == "HttpRequestIP"     ||
-                token.value == "HttpRespond"       || token.value == "HttpRespondFile" ||
-                token.value == "HttpRespondJson"   || token.value == "HttpRespondRedirect" ||
-                // WebSocket
-                token.value == "WsConnect"         || token.value == "WsSend" ||
-                token.value == "WsReceive"         || token.value == "WsReceiveLine" ||
-                token.value == "WsClose"           || token.value == "WsIsConnected" ||
-                // UDP
-                token.value == "UdpCreate"         || token.value == "UdpSend" ||
-                token.value == "UdpReceive"        || token.value == "UdpReceiveFull" ||
-                token.value == "UdpSetTimeout"     || token.value == "UdpClose" ||
-                token.value == "UdpBroadcast") {
-                auto target = std::move(args[0]);
-                std::vector<std::unique_ptr<ASTNode>> rest;
-                for (size_t i = 1; i < args.size(); i++) rest.push_back(std::move(args[i]));
-                return std::make_unique<StringOpNode>(token.value, std::move(target), std::move(rest));
-            }
-
-            // Type conversion
-            if (token.value == "ToNumber" || token.value == "ToString") {
-                return std::make_unique<StringOpNode>(token.value, std::move(args[0]), std::vector<std::unique_ptr<ASTNode>>{});
-            }
+            Builtin id = builtin_id(token.value);
+            if (id != Builtin::Unknown)
+                return builtin_call(id, std::move(args), token);
 
-            return std::make_unique<FuncCallNode>(token.value, std::move(args));
+            return arena.make<FuncCallNode>(token.value, std::move(args));
         }
 
-        return std::make_unique<VariableNode>(token.value);
+        return arena.make<VariableNode>(token.value);
     }
 
     throw std::runtime_error("Unexpected token: '" + token.value + "' on line " + std::to_string(token.line));
 }
 
-std::unique_ptr<ASTNode> Parser::term() {
+// The first argument becomes the target; arguments past the built-in's
+// max_args are dropped
+NodePtr Parser::builtin_call(Builtin id, std::vector<NodePtr> args, const Token& token) {
+    if (args.empty()) {
+        if (!(builtin_info(id).flags & BUILTIN_NULLARY))
+            throw std::runtime_error(token.value + " requires an argument on line " + std::to_string(token.line));
+        args.push_back(arena.make<NullNode>());
+    }
+    int max_args = builtin_info(id).max_args;
+    if (max_args >= 0 && (int)args.size() > max_args) args.resize(max_args);
+    auto target = std::move(args[0]);
+    std::vector<NodePtr> rest;
+    for (size_t i = 1; i < args.size(); i++) rest.push_back(std::move(args[i]));
+    return arena.make<StringOpNode>(id, std::move(target), std::move(rest));
+}
+
+NodePtr Parser::term() {
     auto node = factor();
     while (current_token.type == TokenType::MULTIPLY || current_token.type == TokenType::DIVIDE) {
         TokenType op = current_token.type;
         advance();
-        node = std::make_unique<BinaryOpNode>(op, std::move(node), factor());
+        node = arena.make<BinaryOpNode>(op, std::move(node), factor());
     }
     return node;
 }
 
-std::unique_ptr<ASTNode> Parser::expression() {
+NodePtr Parser::expression() {
     auto node = term();
     while (current_token.type == TokenType::PLUS || current_token.type == TokenType::MINUS) {
         TokenType op = current_token.type;
         advance();
-        node = std::make_unique<BinaryOpNode>(op, std::move(node), term());
+        node = arena.make<BinaryOpNode>(op, std::move(node), term());
     }
     return node;
 }
 
-std::unique_ptr<ASTNode> Parser::comparison() {
+NodePtr Parser::comparison() {
     auto left = expression();
     if (current_token.type == TokenType::EQUAL ||
         current_token.type == TokenType::NOT_EQUAL ||
@@ -288,22 +215,22 @@ std::unique_ptr<ASTNode> Parser::comparison() {
         current_token.type == TokenType::GREATER_EQUAL) {
         TokenType op = current_token.type;
         advance();
-        return std::make_unique<ComparisonNode>(op, std::move(left), expression());
+        return arena.make<ComparisonNode>(op, std::move(left), expression());
     }
     return left;
 }
 
-std::unique_ptr<ASTNode> Parser::logical() {
+NodePtr Parser::logical() {
     auto left = comparison();
     while (current_token.type == TokenType::AND || current_token.type == TokenType::OR) {
         TokenType op = current_token.type;
         advance();
-        left = std::make_unique<LogicalOpNode>(op, std::move(left), comparison());
+        left = arena.make<LogicalOpNode>(op, std::move(left), comparison());
     }
     return left;
 }
 
-std::unique_ptr<ASTNode> Parser::if_statement() {
+NodePtr Parser::if_statement() {
     advance();
     auto condition = logical();
     if (current_token.type != TokenType::NEWLINE)
@@ -326,7 +253,7 @@ std::unique_ptr<ASTNode> Parser::if_statement() {
         elif_clauses.push_back(std::move(clause));
     }
 
-    std::vector<std::unique_ptr<ASTNode>> else_body;
+    std::vector<NodePtr> else_body;
     if (current_token.type == TokenType::ELSE) {
         advance();
         if (current_token.type != TokenType::NEWLINE)
@@ -336,10 +263,10 @@ std::unique_ptr<ASTNode> Parser::if_statement() {
     }
 
     if (current_token.type == TokenType::END) advance();
-    return std::make_unique<IfStatementNode>(std::move(condition), std::move(body), std::move(elif_clauses), std::move(else_body));
+    return arena.make<IfStatementNode>(std::move(condition), std::move(body), std::move(elif_clauses), std::move(else_body));
 }
 
-std::unique_ptr<ASTNode> Parser::while_statement() {
+NodePtr Parser::while_statement() {
     advance();
     auto condition = logical();
     if (current_token.type != TokenType::NEWLINE)
@@ -347,10 +274,10 @@ std::unique_ptr<ASTNode> Parser::while_statement() {
     advance();
     auto body = parse_block();
     if (current_token.type == TokenType::END) advance();
-    return std::make_unique<WhileLoopNode>(std::move(condition), std::move(body));
+    return arena.make<WhileLoopNode>(std::move(condition), std::move(body));
 }
 
-std::unique_ptr<ASTNode> Parser::for_statement() {
+NodePtr Parser::for_statement() {
     advance();
     if (current_token.type != TokenType::IDENTIFIER)
         throw std::runtime_error("Expected variable name after For");
@@ -375,10 +302,10 @@ std::unique_ptr<ASTNode> Parser::for_statement() {
 
     auto body = parse_block();
     if (current_token.type == TokenType::END) advance();
-    return std::make_unique<ForLoopNode>(var, std::move(start), std::move(end), std::move(body));
+    return arena.make<ForLoopNode>(var, std::move(start), std::move(end), std::move(body));
 }
 
-std::unique_ptr<ASTNode> Parser::func_def() {
+NodePtr Parser::func_def() {
     advance();
     if (current_token.type != TokenType::IDENTIFIER)
         throw std::runtime_error("Expected function name");
@@ -390,7 +317,7 @@ std::unique_ptr<ASTNode> Parser::func_def() {
     advance();
 
     std::vector<std::string> params;
-    std::vector<std::unique_ptr<ASTNode>> defaults;
+    std::vector<NodePtr> defaults;
 
     while (current_token.type != TokenType::RPAREN && current_token.type != TokenType::END_OF_FILE) {
         if (current_token.type != TokenType::IDENTIFIER)
@@ -416,10 +343,10 @@ std::unique_ptr<ASTNode> Parser::func_def() {
 
     auto body = parse_block();
     if (current_token.type == TokenType::END) advance();
-    return std::make_unique<FuncDefNode>(name, std::move(params), std::move(defaults), std::move(body));
+    return arena.make<FuncDefNode>(name, std::move(params), std::move(defaults), std::move(body));
 }
 
-std::unique_ptr<ASTNode> Parser::try_statement() {
+NodePtr Parser::try_statement() {
     advance(); // consume Try
     if (current_token.type != TokenType::NEWLINE)
         throw std::runtime_error("Expected newline after Try");
@@ -450,13 +377,13 @@ std::unique_ptr<ASTNode> Parser::try_statement() {
 
     auto catch_body = parse_block();
     if (current_token.type == TokenType::END) advance();
-    return std::make_unique<TryCatchNode>(std::move(try_body), error_var, std::move(catch_body));
+    return arena.make<TryCatchNode>(std::move(try_body), error_var, std::move(catch_body));
 }
 
-std::unique_ptr<ASTNode> Parser::statement() {
+NodePtr Parser::statement() {
     if (current_token.type == TokenType::PRINT) {
         advance();
-        return std::make_unique<PrintNode>(logical());
+        return arena.make<PrintNode>(logical());
     }
     
     if (current_token.type == TokenType::WRITEFILE) {
@@ -472,7 +399,7 @@ std::unique_ptr<ASTNode> Parser::statement() {
         if (current_token.type != TokenType::RPAREN)
             throw std::runtime_error("Expected ')' after WriteFile");
         advance();
-        return std::make_unique<WriteFileNode>(std::move(path), std::move(content));
+        return arena.make<WriteFileNode>(std::move(path), std::move(content));
     }
     
     if (current_token.type == TokenType::APPENDFILE) {
@@ -488,7 +415,7 @@ std::unique_ptr<ASTNode> Parser::statement() {
         if (current_token.type != TokenType::RPAREN)
             throw std::runtime_error("Expected ')' after AppendFile");
         advance();
-        return std::make_unique<AppendFileNode>(std::move(path), std::move(content));
+        return arena.make<AppendFileNode>(std::move(path), std::move(content));
     }
     
     if (current_token.type == TokenType::IF)    return if_statement();
@@ -499,17 +426,17 @@ std::unique_ptr<ASTNode> Parser::statement() {
 
     if (current_token.type == TokenType::RETURN) {
         advance();
-        return std::make_unique<ReturnNode>(logical());
+        return arena.make<ReturnNode>(logical());
     }
 
     if (current_token.type == TokenType::BREAK) {
         advance();
-        return std::make_unique<BreakNode>();
+        return arena.make<BreakNode>();
     }
 
     if (current_token.type == TokenType::CONTINUE) {
         advance();
-        return std::make_unique<ContinueNode>();
+        return arena.make<ContinueNode>();
     }
 
     if (current_token.type == TokenType::IMPORT) {
@@ -518,23 +445,24 @@ std::unique_ptr<ASTNode> Parser::statement() {
             // Import "file.LANGUAGE" — file import
             std::string filepath = current_token.value;
             advance();
-            return std::make_unique<ImportNode>(filepath);
+            return arena.make<ImportNode>(filepath);
         } else if (current_token.type == TokenType::IDENTIFIER) {
             // Import PACKAGENAME — LANGPACK import
             std::string pkg = current_token.value;
             advance();
-            return std::make_unique<LangpackImportNode>(pkg);
+            return arena.make<LangpackImportNode>(pkg);
         }
         throw std::runtime_error("Expected file path or package name after Import");
     }
 
     if (current_token.type == TokenType::IDENTIFIER) {
+        Token name_token = current_token;
         std::string name = current_token.value;
         advance();
 
         if (current_token.type == TokenType::ASSIGN) {
             advance();
-            return std::make_unique<AssignmentNode>(name, logical());
+            return arena.make<AssignmentNode>(name, logical());
         }
 
         if (current_token.type == TokenType::LBRACKET) {
@@ -547,12 +475,12 @@ std::unique_ptr<ASTNode> Parser::statement() {
                 throw std::runtime_error("Expected '=' after index");
             advance();
             // DictAssignNode handles both arrays and dicts at runtime
-            return std::make_unique<DictAssignNode>(name, std::move(index), logical());
+            return arena.make<DictAssignNode>(name, std::move(index), logical());
         }
 
         if (current_token.type == TokenType::LPAREN) {
             advance();
-            std::vector<std::unique_ptr<ASTNode>> args;
+            std::vector<NodePtr> args;
             while (current_token.type != TokenType::RPAREN && current_token.type != TokenType::END_OF_FILE) {
                 args.push_back(logical());
                 if (current_token.type == TokenType::COMMA) advance();
@@ -560,7 +488,11 @@ std::unique_ptr<ASTNode> Parser::statement() {
             if (current_token.type != TokenType::RPAREN)
                 throw std::runtime_error("Expected ')'");
             advance();
-            return std::make_unique<FuncCallNode>(name, std::move(args));
+            // Routed built-ins are statements too, e.g. DictRemove(d, "k")
+            Builtin id = builtin_id(name);
+            if (builtin_info(id).flags & BUILTIN_ROUTED)
+                return builtin_call(id, std::move(args), name_token);
+            return arena.make<FuncCallNode>(name, std::move(args));
         }
 
         throw std::runtime_error("Expected '=', '[', or '(' after identifier '" + name + "'");
@@ -569,8 +501,8 @@ std::unique_ptr<ASTNode> Parser::statement() {
     return nullptr;
 }
 
-std::vector<std::unique_ptr<ASTNode>> Parser::parse() {
-    std::vector<std::unique_ptr<ASTNode>> statements;
+std::vector<NodePtr> Parser::parse() {
+    std::vector<NodePtr> statements;
     consume_newlines();
     while (current_token.type != TokenType::END_OF_FILE) {
         auto stmt = statement();
@@ -587,8 +519,8 @@ std::vector<std::unique_ptr<ASTNode>> Parser::parse() {
 
 // ── Dictionary literal parsing ────────────────────────────────────────────
 // Called after consuming '{', parses key: value pairs until '}'
-std::unique_ptr<ASTNode> Parser::parse_dict() {
-    std::vector<std::pair<std::unique_ptr<ASTNode>, std::unique_ptr<ASTNode>>> pairs;
+NodePtr Parser::parse_dict() {
+    std::vector<std::pair<NodePtr, NodePtr>> pairs;
     while (current_token.type != TokenType::RBRACE && current_token.type != TokenType::END_OF_FILE) {
         auto key = logical();
         if (current_token.type != TokenType::COLON)
@@ -601,14 +533,14 @@ std::unique_ptr<ASTNode> Parser::parse_dict() {
     if (current_token.type != TokenType::RBRACE)
         throw std::runtime_error("Expected '}' after dictionary entries");
     advance();
-    return std::make_unique<DictNode>(std::move(pairs));
+    return arena.make<DictNode>(std::move(pairs));
 }
 
 // ── String interpolation parsing ──────────────────────────────────────────
 // Parses "Hello {name}, you are {age} years old!"
 // into alternating literal/expression segments
-std::unique_ptr<ASTNode> Parser::parse_interp_string(const std::string& raw) {
-    auto node = std::make_unique<InterpStringNode>();
+NodePtr Parser::parse_interp_string(const std::string& raw) {
+    auto node = arena.make<InterpStringNode>();
     size_t i = 0;
     while (i < raw.size()) {
         if (raw[i] == '{') {
@@ -629,7 +561,7 @@ std::unique_ptr<ASTNode> Parser::parse_interp_string(const std::string& raw) {
             // Parse the inner expression
             Lexer inner_lexer(expr_src + "\n");
             auto inner_tokens = inner_lexer.tokenize();
-            Parser inner_parser(inner_tokens);
+            Parser inner_parser(inner_tokens, arena);
             auto expr_ast = inner_parser.logical();
             InterpStringNode::Segment seg;
             seg.is_expr = true;
@@ -659,3 +591,142 @@ std::unique_ptr<ASTNode> Parser::parse_interp_string(const std::string& raw) {
     }
     return node;
 }
+
+// ── AST traversal ─────────────────────────────────────────────────────────
+void visit_children(ASTNode* node, const std::function<void(NodePtr&)>& fn) {
+    auto each = [&](std::vector<NodePtr>& nodes) {
+        for (auto& n : nodes) if (n) fn(n);
+    };
+    auto one = [&](NodePtr& n) {
+        if (n) fn(n);
+    };
+
+    switch (node->type) {
+        case NodeType::ARRAY:
+            each(static_cast<ArrayNode*>(node)->elements);
+            break;
+        case NodeType::ARRAY_ACCESS:
+            one(static_cast<ArrayAccessNode*>(node)->index);
+            break;
+        case NodeType::ARRAY_ASSIGN: {
+            auto* n = static_cast<ArrayAssignNode*>(node);
+            one(n->index);
+            one(n->value);
+            break;
+        }
+        case NodeType::DICT:
+            for (auto& [k, v] : static_cast<DictNode*>(node)->pairs) { one(k); one(v); }
+            break;
+        case NodeType::DICT_ACCESS:
+            one(static_cast<DictAccessNode*>(node)->key);
+            break;
+        case NodeType::DICT_ASSIGN: {
+            auto* n = static_cast<DictAssignNode*>(node);
+            one(n->key);
+            one(n->value);
+            break;
+        }
+        case NodeType::INTERP_STRING:
+            for (auto& seg : static_cast<InterpStringNode*>(node)->segments)
+                if (seg.is_expr) one(seg.expr);
+            break;
+        case NodeType::BINARY_OP: {
+            auto* n = static_cast<BinaryOpNode*>(node);
+            one(n->left);
+            one(n->right);
+            break;
+        }
+        case NodeType::LOGICAL_OP: {
+            auto* n = static_cast<LogicalOpNode*>(node);
+            one(n->left);
+            one(n->right);
+            break;
+        }
+        case NodeType::COMPARISON: {
+            auto* n = static_cast<ComparisonNode*>(node);
+            one(n->left);
+            one(n->right);
+            break;
+        }
+        case NodeType::NOT_OP:
+            one(static_cast<NotOpNode*>(node)->operand);
+            break;
+        case NodeType::ASSIGNMENT:
+            one(static_cast<AssignmentNode*>(node)->value);
+            break;
+        case NodeType::APPEND:
+            one(static_cast<AppendNode*>(node)->value);
+            break;
+        case NodeType::PRINT:
+            one(static_cast<PrintNode*>(node)->expression);
+            break;
+        case NodeType::INPUT:
+            one(static_cast<InputNode*>(node)->prompt);
+            break;
+        case NodeType::READFILE:
+            one(static_cast<ReadFileNode*>(node)->path);
+            break;
+        case NodeType::WRITEFILE: {
+            auto* n = static_cast<WriteFileNode*>(node);
+            one(n->path);
+            one(n->content);
+            break;
+        }
+        case NodeType::APPENDFILE: {
+            auto* n = static_cast<AppendFileNode*>(node);
+            one(n->path);
+            one(n->content);
+            break;
+        }
+        case NodeType::IF_STATEMENT: {
+            auto* n = static_cast<IfStatementNode*>(node);
+            one(n->condition);
+            each(n->body);
+            for (auto& clause : n->elif_clauses) {
+                one(clause.condition);
+                each(clause.body);
+            }
+            each(n->else_body);
+            break;
+        }
+        case NodeType::WHILE_LOOP: {
+            auto* n = static_cast<WhileLoopNode*>(node);
+            one(n->condition);
+            each(n->body);
+            break;
+        }
+        case NodeType::FOR_LOOP: {
+            auto* n = static_cast<ForLoopNode*>(node);
+            one(n->start);
+            one(n->end);
+            each(n->body);
+            break;
+        }
+        case NodeType::FUNC_DEF: {
+            auto* n = static_cast<FuncDefNode*>(node);
+            each(n->defaults);
+            each(n->body);
+            break;
+        }
+        case NodeType::FUNC_CALL:
+            each(static_cast<FuncCallNode*>(node)->args);
+            break;
+        case NodeType::RETURN_STATEMENT:
+            one(static_cast<ReturnNode*>(node)->value);
+            break;
+        case NodeType::STRING_OP: {
+            auto* n = static_cast<StringOpNode*>(node);
+            one(n->target);
+            each(n->args);
+            break;
+        }
+        case NodeType::TRY_CATCH: {
+            auto* n = static_cast<TryCatchNode*>(node);
+            each(n->try_body);
+            each(n->catch_body);
+            break;
+        }
+        default:
+            break; // leaves: literals, variables, Break/Continue, imports
+    }
+}
@@ -1,6 +1,10 @@
 #pragma once
 #include "lexer.h"
+#include "builtins.h"
+#include "value.h"
+#include <functional>
 #include <memory>
+#include <new>
 #include <vector>
 
 enum class NodeType {
@@ -37,7 +41,12 @@ enum class NodeType {
     FUNC_CALL,
     RETURN_STATEMENT,
     STRING_OP,
-    TRY_CATCH
+    TRY_CATCH,
+    // Fused shapes, produced by Optimizer::fuse
+    INCREMENT,
+    APPEND,
+    INDEX_VAR,
+    COMPARE_CONST
 };
 
 struct ASTNode {
@@ -45,14 +54,57 @@ struct ASTNode {
     virtual ~ASTNode() = default;
 };
 
+// ── AST arena ─────────────────────────────────────────────────────────────
+// Every node of a compilation unit (the main script, or one imported file)
+// is bump-allocated from that unit's arena in parse order, so a tree walk
+// touches mostly contiguous memory and the unit is released in one go.
+// Nodes keep their unique_ptr ownership shape through NodePtr, whose deleter
+// runs the destructor but leaves the memory to the arena; node addresses
+// never change, so raw FuncDefNode* pointers stay valid. The arena must
+// outlive every NodePtr it handed out.
+struct NodeDeleter {
+    void operator()(ASTNode* node) const { node->~ASTNode(); }
+};
+template <typename T>
+using ArenaPtr = std::unique_ptr<T, NodeDeleter>;
+using NodePtr = ArenaPtr<ASTNode>;
+
+class AstArena {
+public:
+    AstArena() = default;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    template <typename T, typename... Args>
+    ArenaPtr<T> make(Args&&... args) {
+        void* mem = allocate(sizeof(T), alignof(T));
+        return ArenaPtr<T>(new (mem) T(std::forward<Args>(args)...));
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 32 * 1024;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* next = nullptr;
+    size_t remaining = 0;
+
+    void* allocate(size_t size, size_t align);
+};
+
+// Where a variable lives once the Resolver has run: a slot in the enclosing
+// function's frame (local) or in the interpreter's global table
+struct VarRef {
+    int slot = -1;
+    bool local = false;
+};
+
 struct NumberNode : ASTNode {
     double value;
     NumberNode(double val) : value(val) { type = NodeType::NUMBER; }
 };
 
 struct StringNode : ASTNode {
-    std::string value;
-    StringNode(const std::string& val) : value(val) { type = NodeType::STRING; }
+    Value value;   // interned once here, so evaluating the literal shares it
+    StringNode(const std::string& val) : value(intern(val)) { type = NodeType::STRING; }
 };
 
 struct BooleanNode : ASTNode {
@@ -66,25 +118,27 @@ struct NullNode : ASTNode {
 
 // Dictionary literal: {"key": value, ...}
 struct DictNode : ASTNode {
-    std::vector<std::pair<std::unique_ptr<ASTNode>, std::unique_ptr<ASTNode>>> pairs;
-    DictNode(std::vector<std::pair<std::unique_ptr<ASTNode>, std::unique_ptr<ASTNode>>> p)
+    std::vector<std::pair<NodePtr, NodePtr>> pairs;
+    DictNode(std::vector<std::pair<NodePtr, NodePtr>> p)
         : pairs(std::move(p)) { type = NodeType::DICT; }
 };
 
 // dict["key"] or dict[expr]
 struct DictAccessNode : ASTNode {
     std::string name;
-    std::unique_ptr<ASTNode> key;
-    DictAccessNode(const std::string& n, std::unique_ptr<ASTNode> k)
+    VarRef ref;
+    NodePtr key;
+    DictAccessNode(const std::string& n, NodePtr k)
         : name(n), key(std::move(k)) { type = NodeType::DICT_ACCESS; }
 };
 
 // dict["key"] = value
 struct DictAssignNode : ASTNode {
     std::string name;
-    std::unique_ptr<ASTNode> key;
-    std::unique_ptr<ASTNode> value;
-    DictAssignNode(const std::string& n, std::unique_ptr<ASTNode> k, std::unique_ptr<ASTNode> v)
+    VarRef ref;
+    NodePtr key;
+    NodePtr value;
+    DictAssignNode(const std::string& n, NodePtr k, NodePtr v)
         : name(n), key(std::move(k)), value(std::move(v)) { type = NodeType::DICT_ASSIGN; }
 };
 
@@ -95,7 +149,7 @@ struct InterpStringNode : ASTNode {
     struct Segment {
         bool is_expr;
         std::string literal;
-        std::unique_ptr<ASTNode> expr;
+        NodePtr expr;
     };
     std::vector<Segment> segments;
     InterpStringNode() { type = NodeType::INTERP_STRING; }
@@ -108,104 +162,118 @@ struct LangpackImportNode : ASTNode {
 };
 
 struct ArrayNode : ASTNode {
-    std::vector<std::unique_ptr<ASTNode>> elements;
-    ArrayNode(std::vector<std::unique_ptr<ASTNode>> elems)
+    std::vector<NodePtr> elements;
+    ArrayNode(std::vector<NodePtr> elems)
         : elements(std::move(elems)) { type = NodeType::ARRAY; }
 };
 
 struct ArrayAccessNode : ASTNode {
     std::string name;
-    std::unique_ptr<ASTNode> index;
-    ArrayAccessNode(const std::string& n, std::unique_ptr<ASTNode> i)
+    VarRef ref;
+    NodePtr index;
+    ArrayAccessNode(const std::string& n, NodePtr i)
         : name(n), index(std::move(i)) { type = NodeType::ARRAY_ACCESS; }
 };
 
 struct ArrayAssignNode : ASTNode {
     std::string name;
-    std::unique_ptr<ASTNode> index;
-    std::unique_ptr<ASTNode> value;
-    ArrayAssignNode(const std::string& n, std::unique_ptr<ASTNode> i, std::unique_ptr<ASTNode> v)
+    VarRef ref;
+    NodePtr index;
+    NodePtr value;
+    ArrayAssignNode(const std::string& n, NodePtr i, NodePtr v)
         : name(n), index(std::move(i)), value(std::move(v)) { type = NodeType::ARRAY_ASSIGN; }
 };
 
 struct VariableNode : ASTNode {
     std::string name;
+    VarRef ref;
     VariableNode(const std::string& n) : name(n) { type = NodeType::VARIABLE; }
 };
 
+// Operand types an operator node has seen, recorded by the tree engine the
+// first time the node runs. NUMBERS and STRINGS select a specialised handler
+// on later runs; an operand of another type deoptimizes the node to GENERIC
+// for good, which is the full type dispatch in Interpreter::arithmetic and
+// Interpreter::compare.
+enum class TypeFeedback : uint8_t { UNSEEN, NUMBERS, STRINGS, GENERIC };
+
 struct BinaryOpNode : ASTNode {
     TokenType op;
-    std::unique_ptr<ASTNode> left;
-    std::unique_ptr<ASTNode> right;
-    BinaryOpNode(TokenType o, std::unique_ptr<ASTNode> l, std::unique_ptr<ASTNode> r)
+    TypeFeedback feedback = TypeFeedback::UNSEEN;
+    NodePtr left;
+    NodePtr right;
+    BinaryOpNode(TokenType o, NodePtr l, NodePtr r)
         : op(o), left(std::move(l)), right(std::move(r)) { type = NodeType::BINARY_OP; }
 };
 
 struct LogicalOpNode : ASTNode {
     TokenType op;
-    std::unique_ptr<ASTNode> left;
-    std::unique_ptr<ASTNode> right;
-    LogicalOpNode(TokenType o, std::unique_ptr<ASTNode> l, std::unique_ptr<ASTNode> r)
+    NodePtr left;
+    NodePtr right;
+    LogicalOpNode(TokenType o, NodePtr l, NodePtr r)
         : op(o), left(std::move(l)), right(std::move(r)) { type = NodeType::LOGICAL_OP; }
 };
 
 struct NotOpNode : ASTNode {
-    std::unique_ptr<ASTNode> operand;
-    NotOpNode(std::unique_ptr<ASTNode> op) : operand(std::move(op)) { type = NodeType::NOT_OP; }
+    NodePtr operand;
+    NotOpNode(NodePtr op) : operand(std::move(op)) { type = NodeType::NOT_OP; }
 };
 
 struct ComparisonNode : ASTNode {
     TokenType op;
-    std::unique_ptr<ASTNode> left;
-    std::unique_ptr<ASTNode> right;
-    ComparisonNode(TokenType o, std::unique_ptr<ASTNode> l, std::unique_ptr<ASTNode> r)
+    TypeFeedback feedback = TypeFeedback::UNSEEN;
+    NodePtr left;
+    NodePtr right;
+    ComparisonNode(TokenType o, NodePtr l, NodePtr r)
         : op(o), left(std::move(l)), right(std::move(r)) { type = NodeType::COMPARISON; }
 };
 
 struct AssignmentNode : ASTNode {
     std::string var_name;
-    std::unique_ptr<ASTNode> value;
-    AssignmentNode(const std::string& name, std::unique_ptr<ASTNode> val)
+    VarRef ref;
+    NodePtr value;
+    AssignmentNode(const std::string& name, NodePtr val)
         : var_name(name), value(std::move(val)) { type = NodeType::ASSIGNMENT; }
 };
 
 struct PrintNode : ASTNode {
-    std::unique_ptr<ASTNode> expression;
-    PrintNode(std::unique_ptr<ASTNode> expr) : expression(std::move(expr)) { type = NodeType::PRINT; }
+    NodePtr expression;
+    PrintNode(NodePtr expr) : expression(std::move(expr)) { type = NodeType::PRINT; }
 };
 
 struct ElifClause {
-    std::unique_ptr<ASTNode> condition;
-    std::vector<std::unique_ptr<ASTNode>> body;
+    NodePtr condition;
+    std::vector<NodePtr> body;
 };
 
 struct IfStatementNode : ASTNode {
-    std::unique_ptr<ASTNode> condition;
-    std::vector<std::unique_ptr<ASTNode>> body;
+    NodePtr condition;
+    std::vector<NodePtr> body;
     std::vector<ElifClause> elif_clauses;
-    std::vector<std::unique_ptr<ASTNode>> else_body;
-    IfStatementNode(std::unique_ptr<ASTNode> cond,
-                    std::vector<std::unique_ptr<ASTNode>> b,
+    std::vector<NodePtr> else_body;
+    IfStatementNode(NodePtr cond,
+                    std::vector<NodePtr> b,
                     std::vector<ElifClause> elif,
-                    std::vector<std::unique_ptr<ASTNode>> eb)
+                    std::vector<NodePtr> eb)
         : condition(std::move(cond)), body(std::move(b)),
           elif_clauses(std::move(elif)), else_body(std::move(eb)) { type = NodeType::IF_STATEMENT; }
 };
 
 struct WhileLoopNode : ASTNode {
-    std::unique_ptr<ASTNode> condition;
-    std::vector<std::unique_ptr<ASTNode>> body;
-    WhileLoopNode(std::unique_ptr<ASTNode> cond, std::vector<std::unique_ptr<ASTNode>> b)
+    NodePtr condition;
+    std::vector<NodePtr> body;
+    WhileLoopNode(NodePtr cond, std::vector<NodePtr> b)
         : condition(std::move(cond)), body(std::move(b)) { type = NodeType::WHILE_LOOP; }
 };
 
 struct ForLoopNode : ASTNode {
     std::string var;
-    std::unique_ptr<ASTNode> start;
-    std::unique_ptr<ASTNode> end;
-    std::vector<std::unique_ptr<ASTNode>> body;
-    ForLoopNode(const std::string& v, std::unique_ptr<ASTNode> s, std::unique_ptr<ASTNode> e,
-                std::vector<std::unique_ptr<ASTNode>> b)
+    VarRef var_ref;
+    NodePtr start;
+    NodePtr end;
+    std::vector<NodePtr> body;
+    ForLoopNode(const std::string& v, NodePtr s, NodePtr e,
+                std::vector<NodePtr> b)
         : var(v), start(std::move(s)), end(std::move(e)), body(std::move(b)) { type = NodeType::FOR_LOOP; }
 };
 
@@ -222,94 +290,173 @@ struct ImportNode : ASTNode {
     ImportNode(const std::string& path) : filepath(path) { type = NodeType::IMPORT_STATEMENT; }
 };
 
+struct JitCode;
+
 struct FuncDefNode : ASTNode {
     std::string name;
     std::vector<std::string> params;
-    std::vector<std::unique_ptr<ASTNode>> defaults; // nullptr = no default, expr = has default
-    std::vector<std::unique_ptr<ASTNode>> body;
+    std::vector<NodePtr> defaults; // nullptr = no default, expr = has default
+    std::vector<NodePtr> body;
+    // Filled in by the Resolver: params take slots 0..n-1, then assigned locals
+    int num_locals = 0;
+    std::vector<std::string> local_names;
+#if defined(USE_JIT)
+    // Tier-up state (jit.h): calls counted until Jit::THRESHOLD, then the
+    // native code if the body compiled; owned by the Jit
+    uint32_t call_count = 0;
+    JitCode* jit = nullptr;
+#endif
     FuncDefNode(const std::string& n, std::vector<std::string> p,
-                std::vector<std::unique_ptr<ASTNode>> d,
-                std::vector<std::unique_ptr<ASTNode>> b)
+                std::vector<NodePtr> d,
+                std::vector<NodePtr> b)
         : name(n), params(std::move(p)), defaults(std::move(d)), body(std::move(b)) { type = NodeType::FUNC_DEF; }
 };
 
 struct FuncCallNode : ASTNode {
     std::string name;
-    std::vector<std::unique_ptr<ASTNode>> args;
-    FuncCallNode(const std::string& n, std::vector<std::unique_ptr<ASTNode>> a)
+    std::vector<NodePtr> args;
+    // Inline cache: what name resolved to, valid while cache_generation
+    // matches the interpreter's call_generation (Interpreter::resolve_call)
+    enum class Target : uint8_t { RANDOM, STATS, NATIVE, USER, UNDEFINED };
+    Target target = Target::UNDEFINED;
+    Builtin builtin = Builtin::Unknown;                          // STATS
+    std::function<Value(std::vector<Value>)>* native = nullptr;  // NATIVE
+    FuncDefNode* func = nullptr;                                 // USER
+    uint32_t cache_generation = 0;
+    FuncCallNode(const std::string& n, std::vector<NodePtr> a)
         : name(n), args(std::move(a)) { type = NodeType::FUNC_CALL; }
 };
 
 struct ReturnNode : ASTNode {
-    std::unique_ptr<ASTNode> value;
-    ReturnNode(std::unique_ptr<ASTNode> val) : value(std::move(val)) { type = NodeType::RETURN_STATEMENT; }
+    NodePtr value;
+    // Set by the Resolver on `Return F(...)` inside F, outside any Try body.
+    // If F still names the running function the call reuses its frame.
+    bool tail_call = false;
+    ReturnNode(NodePtr val) : value(std::move(val)) { type = NodeType::RETURN_STATEMENT; }
 };
 
 struct StringOpNode : ASTNode {
     std::string op;
-    std::unique_ptr<ASTNode> target;
-    std::vector<std::unique_ptr<ASTNode>> args;
-    StringOpNode(const std::string& o, std::unique_ptr<ASTNode> t, std::vector<std::unique_ptr<ASTNode>> a)
-        : op(o), target(std::move(t)), args(std::move(a)) { type = NodeType::STRING_OP; }
+    Builtin id;     // resolved from op when the node is built
+    NodePtr target;
+    std::vector<NodePtr> args;
+    StringOpNode(const std::string& o, NodePtr t, std::vector<NodePtr> a)
+        : op(o), id(builtin_id(o)), target(std::move(t)), args(std::move(a)) { type = NodeType::STRING_OP; }
+    StringOpNode(Builtin b, NodePtr t, std::vector<NodePtr> a)
+        : op(builtin_info(b).name), id(b), target(std::move(t)), args(std::move(a)) { type = NodeType::STRING_OP; }
 };
 
 struct InputNode : ASTNode {
-    std::unique_ptr<ASTNode> prompt;
-    InputNode(std::unique_ptr<ASTNode> p) : prompt(std::move(p)) { type = NodeType::INPUT; }
+    NodePtr prompt;
+    InputNode(NodePtr p) : prompt(std::move(p)) { type = NodeType::INPUT; }
 };
 
 struct ReadFileNode : ASTNode {
-    std::unique_ptr<ASTNode> path;
-    ReadFileNode(std::unique_ptr<ASTNode> p) : path(std::move(p)) { type = NodeType::READFILE; }
+    NodePtr path;
+    ReadFileNode(NodePtr p) : path(std::move(p)) { type = NodeType::READFILE; }
 };
 
 struct WriteFileNode : ASTNode {
-    std::unique_ptr<ASTNode> path;
-    std::unique_ptr<ASTNode> content;
-    WriteFileNode(std::unique_ptr<ASTNode> p, std::unique_ptr<ASTNode> c) 
+    NodePtr path;
+    NodePtr content;
+    WriteFileNode(NodePtr p, NodePtr c) 
         : path(std::move(p)), content(std::move(c)) { type = NodeType::WRITEFILE; }
 };
 
 struct AppendFileNode : ASTNode {
-    std::unique_ptr<ASTNode> path;
-    std::unique_ptr<ASTNode> content;
-    AppendFileNode(std::unique_ptr<ASTNode> p, std::unique_ptr<ASTNode> c) 
+    NodePtr path;
+    NodePtr content;
+    AppendFileNode(NodePtr p, NodePtr c) 
         : path(std::move(p)), content(std::move(c)) { type = NodeType::APPENDFILE; }
 };
 
 struct TryCatchNode : ASTNode {
-    std::vector<std::unique_ptr<ASTNode>> try_body;
+    std::vector<NodePtr> try_body;
     std::string error_var;
-    std::vector<std::unique_ptr<ASTNode>> catch_body;
-    TryCatchNode(std::vector<std::unique_ptr<ASTNode>> tb, const std::string& ev,
-                 std::vector<std::unique_ptr<ASTNode>> cb)
+    VarRef error_ref;
+    std::vector<NodePtr> catch_body;
+    TryCatchNode(std::vector<NodePtr> tb, const std::string& ev,
+                 std::vector<NodePtr> cb)
         : try_body(std::move(tb)), error_var(ev), catch_body(std::move(cb)) { type = NodeType::TRY_CATCH; }
 };
 
+// ── Fused nodes ───────────────────────────────────────────────────────────
+// Optimizer::fuse replaces a few hot shapes with these after resolution, so
+// the tree walker runs one case instead of walking three or four nodes and
+// copying each intermediate Value. Only AppendNode keeps a child node.
+
+// x = x + c  or  x = x - c, with c a number literal
+struct IncrementNode : ASTNode {
+    std::string name;
+    VarRef ref;
+    TokenType op;       // PLUS or MINUS
+    double amount;
+    IncrementNode(const std::string& n, VarRef r, TokenType o, double a)
+        : name(n), ref(r), op(o), amount(a) { type = NodeType::INCREMENT; }
+};
+
+// x = x + e for any other e. A string is appended to in place when x holds
+// the only reference (Value::append), so building a string up in a loop is
+// linear rather than quadratic; numbers add unboxed.
+struct AppendNode : ASTNode {
+    std::string name;
+    VarRef ref;
+    NodePtr value;
+    AppendNode(const std::string& n, VarRef r, NodePtr v)
+        : name(n), ref(r), value(std::move(v)) { type = NodeType::APPEND; }
+};
+
+// name[index] where index is a plain variable
+struct IndexVarNode : ASTNode {
+    std::string name;
+    VarRef ref;
+    std::string index_name;
+    VarRef index_ref;
+    IndexVarNode(const std::string& n, VarRef r, const std::string& in, VarRef ir)
+        : name(n), ref(r), index_name(in), index_ref(ir) { type = NodeType::INDEX_VAR; }
+};
+
+// variable <op> literal as a condition; a literal on the left is moved right
+// and op flipped
+struct CompareConstNode : ASTNode {
+    TokenType op;
+    std::string name;
+    VarRef ref;
+    Value constant;
+    CompareConstNode(TokenType o, const std::string& n, VarRef r, Value c)
+        : op(o), name(n), ref(r), constant(std::move(c)) { type = NodeType::COMPARE_CONST; }
+};
+
+// Calls fn on every direct child node slot of node (skipping empty slots), so
+// passes over the AST can walk or replace children without a switch of their own
+void visit_children(ASTNode* node, const std::function<void(NodePtr&)>& fn);
+
 class Parser {
 public:
-    Parser(const std::vector<Token>& tokens);
-    std::vector<std::unique_ptr<ASTNode>> parse();
+    Parser(const std::vector<Token>& tokens, AstArena& arena);  // nodes go in arena
+    std::vector<NodePtr> parse();
 
 private:
+    AstArena& arena;
     std::vector<Token> tokens;
     size_t pos;
     Token current_token;
 
     void advance();
     void consume_newlines();
-    std::vector<std::unique_ptr<ASTNode>> parse_block();
-    std::unique_ptr<ASTNode> statement();
-    std::unique_ptr<ASTNode> if_statement();
-    std::unique_ptr<ASTNode> while_statement();
-    std::unique_ptr<ASTNode> for_statement();
-    std::unique_ptr<ASTNode> func_def();
-    std::unique_ptr<ASTNode> try_statement();
-    std::unique_ptr<ASTNode> logical();
-    std::unique_ptr<ASTNode> comparison();
-    std::unique_ptr<ASTNode> expression();
-    std::unique_ptr<ASTNode> term();
-    std::unique_ptr<ASTNode> factor();
-    std::unique_ptr<ASTNode> parse_dict();
-    std::unique_ptr<ASTNode> parse_interp_string(const std::string& raw);
+    std::vector<NodePtr> parse_block();
+    NodePtr statement();
+    NodePtr if_statement();
+    NodePtr while_statement();
+    NodePtr for_statement();
+    NodePtr func_def();
+    NodePtr try_statement();
+    NodePtr logical();
+    NodePtr comparison();
+    NodePtr expression();
+    NodePtr term();
+    NodePtr factor();
+    NodePtr builtin_call(Builtin id, std::vector<NodePtr> args, const Token& token);
+    NodePtr parse_dict();
+    NodePtr parse_interp_string(const std::string& raw);
 };
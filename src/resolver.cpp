@@ -0,0 +1,150 @@
+#include "resolver.h"
+
+int GlobalTable::slot_for(const std::string& name) {
+    auto it = slots.find(name);
+    if (it != slots.end()) return it->second;
+    int slot = (int)names.size();
+    slots.emplace(name, slot);
+    names.push_back(name);
+    return slot;
+}
+
+int GlobalTable::find(const std::string& name) const {
+    auto it = slots.find(name);
+    return it != slots.end() ? it->second : -1;
+}
+
+void Resolver::resolve(const std::vector<NodePtr>& program) {
+    for (const auto& stmt : program)
+        resolve_node(stmt.get());
+}
+
+VarRef Resolver::lookup(const std::string& name) {
+    VarRef ref;
+    if (current_func) {
+        auto it = locals.find(name);
+        if (it != locals.end()) {
+            ref.slot = it->second;
+            ref.local = true;
+            return ref;
+        }
+    }
+    ref.slot = globals.slot_for(name);
+    return ref;
+}
+
+void Resolver::declare_local(const std::string& name) {
+    if (locals.count(name)) return;
+    locals[name] = current_func->num_locals++;
+    current_func->local_names.push_back(name);
+}
+
+// Every name a function body binds becomes a local — nested Func bodies are
+// their own scope and are skipped here
+void Resolver::collect_locals(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::ASSIGNMENT:
+            declare_local(static_cast<AssignmentNode*>(node)->var_name);
+            break;
+        case NodeType::FOR_LOOP:
+            declare_local(static_cast<ForLoopNode*>(node)->var);
+            break;
+        case NodeType::TRY_CATCH:
+            declare_local(static_cast<TryCatchNode*>(node)->error_var);
+            break;
+        case NodeType::FUNC_DEF:
+            return;
+        default:
+            break;
+    }
+    visit_children(node, [&](NodePtr& child) { collect_locals(child.get()); });
+}
+
+void Resolver::resolve_function(FuncDefNode* func) {
+    FuncDefNode* saved_func = current_func;
+    std::map<std::string, int> saved_locals = std::move(locals);
+    int saved_try_depth = try_depth;
+
+    current_func = func;
+    try_depth = 0;
+    locals.clear();
+    func->num_locals = 0;
+    func->local_names.clear();
+    for (const auto& param : func->params)
+        declare_local(param);
+    for (const auto& stmt : func->body)
+        collect_locals(stmt.get());
+
+    for (auto& def : func->defaults)
+        if (def) resolve_node(def.get());
+    for (const auto& stmt : func->body)
+        resolve_node(stmt.get());
+
+    current_func = saved_func;
+    locals = std::move(saved_locals);
+    try_depth = saved_try_depth;
+}
+
+void Resolver::resolve_node(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::VARIABLE: {
+            auto* n = static_cast<VariableNode*>(node);
+            n->ref = lookup(n->name);
+            break;
+        }
+        case NodeType::ASSIGNMENT: {
+            auto* n = static_cast<AssignmentNode*>(node);
+            n->ref = lookup(n->var_name);
+            break;
+        }
+        case NodeType::DICT_ACCESS: {
+            auto* n = static_cast<DictAccessNode*>(node);
+            n->ref = lookup(n->name);
+            break;
+        }
+        case NodeType::DICT_ASSIGN: {
+            auto* n = static_cast<DictAssignNode*>(node);
+            n->ref = lookup(n->name);
+            break;
+        }
+        case NodeType::ARRAY_ACCESS: {
+            auto* n = static_cast<ArrayAccessNode*>(node);
+            n->ref = lookup(n->name);
+            break;
+        }
+        case NodeType::ARRAY_ASSIGN: {
+            auto* n = static_cast<ArrayAssignNode*>(node);
+            n->ref = lookup(n->name);
+            break;
+        }
+        case NodeType::FOR_LOOP: {
+            auto* n = static_cast<ForLoopNode*>(node);
+            n->var_ref = lookup(n->var);
+            break;
+        }
+        case NodeType::TRY_CATCH: {
+            auto* n = static_cast<TryCatchNode*>(node);
+            n->error_ref = lookup(n->error_var);
+            // A Return inside the Try body must keep its frame: the
+            // handler has to see errors raised by the call
+            try_depth++;
+            for (auto& stmt : n->try_body) resolve_node(stmt.get());
+            try_depth--;
+            for (auto& stmt : n->catch_body) resolve_node(stmt.get());
+            return;
+        }
+        case NodeType::RETURN_STATEMENT: {
+            auto* n = static_cast<ReturnNode*>(node);
+            n->tail_call = current_func && try_depth == 0 &&
+                           n->value->type == NodeType::FUNC_CALL &&
+                           static_cast<FuncCallNode*>(n->value.get())->name == current_func->name;
+            break;
+        }
+        case NodeType::FUNC_DEF:
+            resolve_function(static_cast<FuncDefNode*>(node));
+            return;
+        default:
+            break;
+    }
+    visit_children(node, [&](NodePtr& child) { resolve_node(child.get()); });
+}
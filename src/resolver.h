@@ -0,0 +1,39 @@
+#pragma once
+#include "parser.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Global variable names → slot indices. Owned by the Interpreter so the main
+// script and every imported file share one global table.
+struct GlobalTable {
+    std::unordered_map<std::string, int> slots;
+    std::vector<std::string> names;
+
+    int slot_for(const std::string& name);       // adds the name if it's new
+    int find(const std::string& name) const;     // -1 if unknown
+};
+
+// Resolver — runs after Parser::parse() and gives every variable reference a
+// slot, so the interpreter reads and writes vectors instead of name lookups.
+// Inside a function, parameters and any name the body assigns (=, For, Catch)
+// are locals; everything else refers to the global table. It also flags
+// self-recursive calls in tail position (ReturnNode::tail_call).
+class Resolver {
+public:
+    explicit Resolver(GlobalTable& globals) : globals(globals) {}
+    void resolve(const std::vector<NodePtr>& program);
+
+private:
+    GlobalTable& globals;
+    FuncDefNode* current_func = nullptr;
+    std::map<std::string, int> locals;
+    int try_depth = 0;      // Try bodies of current_func enclosing this node
+
+    VarRef lookup(const std::string& name);
+    void declare_local(const std::string& name);
+    void collect_locals(ASTNode* node);
+    void resolve_function(FuncDefNode* func);
+    void resolve_node(ASTNode* node);
+};
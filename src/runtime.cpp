@@ -0,0 +1,122 @@
+#include "runtime.h"
+#include <iostream>
+
+int Runtime::run(void (*unit)(Runtime&)) {
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        std::cerr << "Error: Failed to initialize Winsock\n";
+        return 1;
+    }
+#endif
+    int status = 0;
+    try {
+        unit(*this);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        status = 1;
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return status;
+}
+
+// ── Indexing ──────────────────────────────────────────────────────────────
+// container[key] as an expression: dicts give Null for a missing key
+Value Runtime::index(const Value& container, const Value& key, const char* name) {
+    if (container.is_dict()) {
+        Value* elem = container.dict()->find(Dict::key_of(key));
+        return elem ? *elem : Value::make_null();
+    }
+    if (container.is_array() || container.is_number_array()) return element(container, key);
+    throw std::runtime_error(std::string(name) + " is not an array or dictionary");
+}
+
+const Value& Runtime::check_array(const Value& container, const char* name) {
+    if (!container.is_array() && !container.is_number_array())
+        throw std::runtime_error(std::string(name) + " is not an array");
+    return container;
+}
+
+Value Runtime::element(const Value& array, const Value& index) {
+    Value scratch;
+    return Interpreter::lookup(array, index, "", scratch);
+}
+
+void Runtime::store_index(Value& container, const Value& key, Value value, const char* name) {
+    if (container.is_array()) {
+        int i = (int)key.number();
+        if (i < 0 || i >= (int)container.array()->size())
+            throw std::runtime_error("Array index out of bounds");
+        (*container.array())[i] = std::move(value);
+    } else if (container.is_dict()) {
+        (*container.dict())[Dict::key_of(key)] = std::move(value);
+    } else {
+        Interpreter::store(container, key, std::move(value), name);   // NumberArray or error
+    }
+}
+
+void Runtime::pop(Value& array) {
+    bool empty = array.is_array() ? array.array()->empty() : array.number_array()->empty();
+    if (empty) throw std::runtime_error("Cannot Pop from empty array");
+    if (array.is_array()) array.array()->pop_back();
+    else array.number_array()->pop_back();
+}
+
+// ── Calls ─────────────────────────────────────────────────────────────────
+void Runtime::define(const Function* func) {
+    const Function*& entry = functions[func->name];
+    if (entry != func) {
+        entry = func;
+        interp.call_generation++;
+    }
+}
+
+// Same order as Interpreter::resolve_call: LANGPACK natives shadow Funcs
+Runtime::Target Runtime::resolve(CallSite& site, size_t argc) {
+    if (site.generation != interp.call_generation) {
+        site.generation = interp.call_generation;
+        site.target = Target();
+        auto native = interp.native_functions.find(site.name);
+        if (native != interp.native_functions.end()) {
+            site.target.native = &native->second;
+        } else {
+            auto fn = functions.find(site.name);
+            if (fn != functions.end()) site.target.func = fn->second;
+        }
+    }
+    const Target& target = site.target;
+    if (target.native) return target;
+    if (!target.func) throw std::runtime_error(std::string("Undefined function: ") + site.name);
+
+    const Function* func = target.func;
+    if (argc < func->required || argc > func->params)
+        throw std::runtime_error(std::string("Function '") + func->name + "' expects " +
+            std::to_string(func->required) + "-" + std::to_string(func->params) + " arguments, got " +
+            std::to_string(argc));
+    return target;
+}
+
+Value Runtime::invoke(const Target& target, std::vector<Value>& args) {
+    if (target.native) return (*target.native)(args);
+    return target.func->body(*this, args);
+}
+
+void Runtime::outside_loop(const LoopEscape& escape) {
+    Interpreter::outside_loop(escape.is_break ? ExecStatus::BREAK : ExecStatus::CONTINUE);
+}
+
+// ── Imports ───────────────────────────────────────────────────────────────
+// LANGPACKs are searched for next to the file that imports them
+void Runtime::load_langpack(const char* name, const char* dir) {
+    interp.set_current_dir(dir);
+    interp.load_langpack(name);
+}
+
+bool Runtime::first_import(size_t unit) {
+    if (unit >= imported.size()) imported.resize(unit + 1);
+    if (imported[unit]) return false;
+    imported[unit] = true;
+    return true;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "interpreter.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Runtime — what programs produced by `LANGUAGE --emit-cpp` (transpiler.h)
+// run on. The generated code holds variables in Slots and user functions as
+// plain C++ functions, and comes here for the per-node work the interpreter
+// would do: arithmetic, comparisons, indexing, calls by name, built-ins and
+// LANGPACK natives. It is built into the language_runtime library.
+class Runtime {
+public:
+    struct Slot {
+        Value value;
+        bool defined = false;
+    };
+
+    using Body = Value (*)(Runtime& rt, std::vector<Value>& args);
+    struct Function {
+        const char* name;
+        size_t params;
+        size_t required;    // parameters without a default
+        Body body;
+    };
+
+    // Resolution of a call by name, redone when a Func or LANGPACK changes
+    // the function tables (Interpreter::call_generation)
+    struct Target {
+        const Function* func = nullptr;
+        Interpreter::NativeFunction* native = nullptr;
+    };
+    struct CallSite {
+        const char* name;
+        uint32_t generation = 0;
+        Target target;
+    };
+
+    // Break/Continue outside any loop. Not a std::exception, so a Try passes
+    // it on to the function or file boundary, which reports it with
+    // outside_loop() as the interpreter does.
+    struct LoopEscape {
+        bool is_break;
+    };
+
+    explicit Runtime(size_t global_count) : globals(global_count) {}
+
+    // Runs a compiled file, reporting errors like the interpreter; the exit code
+    int run(void (*unit)(Runtime&));
+
+    std::vector<Slot> globals;
+
+    // ── Variables ──
+    // A local that is not assigned yet reads the global with its name
+    // (fallback, -1 if there is none), as Interpreter::find_variable does
+    Value& var(Slot& slot, int fallback, const char* name) {
+        if (slot.defined) return slot.value;
+        if (fallback >= 0 && globals[fallback].defined) return globals[fallback].value;
+        throw std::runtime_error(std::string("Undefined variable: ") + name);
+    }
+    static Value& assign(Slot& slot) {
+        slot.defined = true;
+        return slot.value;
+    }
+
+    // ── Operators ──
+    static Value arithmetic(TokenType op, const Value& left, const Value& right) {
+        if (left.is_number() && right.is_number()) {
+            switch (op) {
+                case TokenType::PLUS:     return Value(left.number() + right.number());
+                case TokenType::MINUS:    return Value(left.number() - right.number());
+                case TokenType::MULTIPLY: return Value(left.number() * right.number());
+                default: break;
+            }
+        }
+        return Interpreter::arithmetic(op, left, right);
+    }
+    // x = x + e: appends to x's string in place when it can
+    static void append(Value& target, Value left, const Value& right) {
+        if (left.is_number() && right.is_number()) target = Value(left.number() + right.number());
+        else Interpreter::append_to(target, std::move(left), right);
+    }
+    static bool compare(TokenType op, const Value& left, const Value& right) {
+        return Interpreter::compare(op, left, right);
+    }
+    static Value index(const Value& container, const Value& key, const char* name);
+    static const Value& check_array(const Value& container, const char* name);
+    static Value element(const Value& array, const Value& index);
+    static void store_index(Value& container, const Value& key, Value value, const char* name);
+    // Push/Pop statements on a checked array or NumberArray
+    static void push(Value& array, Value value) { Interpreter::push(array, std::move(value)); }
+    static void pop(Value& array);
+
+    // ── Calls ──
+    void define(const Function* func);
+    // Resolves before the arguments are evaluated, throwing for an unknown
+    // name or a wrong argument count
+    Target resolve(CallSite& site, size_t argc);
+    Value invoke(const Target& target, std::vector<Value>& args);
+    Value builtin(Builtin id, const Value& target, const std::vector<Value>& args) {
+        return interp.call_builtin(id, target, args);
+    }
+    static Value random() { return Interpreter::random_number(); }
+    static Value statistic(Builtin id, const Value& arr) { return Interpreter::statistic(id, arr); }
+    [[noreturn]] static void outside_loop(const LoopEscape& escape);
+
+    // ── Statements ──
+    static Value input(const Value& prompt) { return Interpreter::read_input(prompt); }
+    static Value read_file(const Value& path) { return Interpreter::read_file(path); }
+    static void write_file(const Value& path, const Value& content, bool append) {
+        Interpreter::write_file(path, content, append);
+    }
+    void load_langpack(const char* name, const char* dir);
+    bool first_import(size_t unit);     // true once per imported file
+
+private:
+    Interpreter interp;     // built-ins, LANGPACK natives, socket state
+    std::map<std::string, const Function*> functions;
+    std::vector<bool> imported;
+};
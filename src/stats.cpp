@@ -0,0 +1,252 @@
+#include "stats.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define STATS_SSE2 1
+#include <emmintrin.h>
+#endif
+#if STATS_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#define STATS_AVX2 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+// Min and max keep the running value unless the new one is strictly
+// smaller (larger), the same rule MINPD/MAXPD apply lane by lane, so every
+// kernel agrees on which of two equal or unordered values wins
+static inline double min2(double m, double x) { return m < x ? m : x; }
+static inline double max2(double m, double x) { return m > x ? m : x; }
+
+// ── Scalar ────────────────────────────────────────────────────────────────
+#if !STATS_SSE2
+static double sum_scalar(const double* xs, size_t n) {
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += xs[i];
+    return s;
+}
+
+static double product_scalar(const double* xs, size_t n) {
+    double p = 1;
+    for (size_t i = 0; i < n; i++) p *= xs[i];
+    return p;
+}
+
+static double min_scalar(const double* xs, size_t n) {
+    double m = xs[0];
+    for (size_t i = 1; i < n; i++) m = min2(m, xs[i]);
+    return m;
+}
+
+static double max_scalar(const double* xs, size_t n) {
+    double m = xs[0];
+    for (size_t i = 1; i < n; i++) m = max2(m, xs[i]);
+    return m;
+}
+
+static double squared_deviations_scalar(const double* xs, size_t n, double mean) {
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += (xs[i] - mean) * (xs[i] - mean);
+    return s;
+}
+#endif
+
+// ── SSE2 ──────────────────────────────────────────────────────────────────
+// Two lanes, four accumulators to cover the add latency
+#if STATS_SSE2
+static inline double lanes_sum(__m128d v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+static inline double lanes_product(__m128d v) { return _mm_cvtsd_f64(_mm_mul_sd(v, _mm_unpackhi_pd(v, v))); }
+static inline double lanes_min(__m128d v) { return min2(_mm_cvtsd_f64(v), _mm_cvtsd_f64(_mm_unpackhi_pd(v, v))); }
+static inline double lanes_max(__m128d v) { return max2(_mm_cvtsd_f64(v), _mm_cvtsd_f64(_mm_unpackhi_pd(v, v))); }
+
+static double sum_sse2(const double* xs, size_t n) {
+    __m128d a0 = _mm_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm_add_pd(a0, _mm_loadu_pd(xs + i));
+        a1 = _mm_add_pd(a1, _mm_loadu_pd(xs + i + 2));
+        a2 = _mm_add_pd(a2, _mm_loadu_pd(xs + i + 4));
+        a3 = _mm_add_pd(a3, _mm_loadu_pd(xs + i + 6));
+    }
+    for (; i + 2 <= n; i += 2) a0 = _mm_add_pd(a0, _mm_loadu_pd(xs + i));
+    double s = lanes_sum(_mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3)));
+    for (; i < n; i++) s += xs[i];
+    return s;
+}
+
+static double product_sse2(const double* xs, size_t n) {
+    __m128d a0 = _mm_set1_pd(1.0), a1 = a0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm_mul_pd(a0, _mm_loadu_pd(xs + i));
+        a1 = _mm_mul_pd(a1, _mm_loadu_pd(xs + i + 2));
+    }
+    double p = lanes_product(_mm_mul_pd(a0, a1));
+    for (; i < n; i++) p *= xs[i];
+    return p;
+}
+
+static double min_sse2(const double* xs, size_t n) {
+    __m128d a0 = _mm_set1_pd(xs[0]), a1 = a0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm_min_pd(a0, _mm_loadu_pd(xs + i));
+        a1 = _mm_min_pd(a1, _mm_loadu_pd(xs + i + 2));
+    }
+    double m = lanes_min(_mm_min_pd(a0, a1));
+    for (; i < n; i++) m = min2(m, xs[i]);
+    return m;
+}
+
+static double max_sse2(const double* xs, size_t n) {
+    __m128d a0 = _mm_set1_pd(xs[0]), a1 = a0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm_max_pd(a0, _mm_loadu_pd(xs + i));
+        a1 = _mm_max_pd(a1, _mm_loadu_pd(xs + i + 2));
+    }
+    double m = lanes_max(_mm_max_pd(a0, a1));
+    for (; i < n; i++) m = max2(m, xs[i]);
+    return m;
+}
+
+static double squared_deviations_sse2(const double* xs, size_t n, double mean) {
+    const __m128d mu = _mm_set1_pd(mean);
+    __m128d a0 = _mm_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128d d0 = _mm_sub_pd(_mm_loadu_pd(xs + i), mu);
+        __m128d d1 = _mm_sub_pd(_mm_loadu_pd(xs + i + 2), mu);
+        __m128d d2 = _mm_sub_pd(_mm_loadu_pd(xs + i + 4), mu);
+        __m128d d3 = _mm_sub_pd(_mm_loadu_pd(xs + i + 6), mu);
+        a0 = _mm_add_pd(a0, _mm_mul_pd(d0, d0));
+        a1 = _mm_add_pd(a1, _mm_mul_pd(d1, d1));
+        a2 = _mm_add_pd(a2, _mm_mul_pd(d2, d2));
+        a3 = _mm_add_pd(a3, _mm_mul_pd(d3, d3));
+    }
+    double s = lanes_sum(_mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3)));
+    for (; i < n; i++) s += (xs[i] - mean) * (xs[i] - mean);
+    return s;
+}
+#endif
+
+// ── AVX2 ──────────────────────────────────────────────────────────────────
+// Four lanes; compiled for AVX2 function by function, so the rest of the
+// binary still runs on any x86-64
+#if STATS_AVX2
+TARGET_AVX2 static double sum_avx2(const double* xs, size_t n) {
+    __m256d a0 = _mm256_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(xs + i));
+        a1 = _mm256_add_pd(a1, _mm256_loadu_pd(xs + i + 4));
+        a2 = _mm256_add_pd(a2, _mm256_loadu_pd(xs + i + 8));
+        a3 = _mm256_add_pd(a3, _mm256_loadu_pd(xs + i + 12));
+    }
+    for (; i + 4 <= n; i += 4) a0 = _mm256_add_pd(a0, _mm256_loadu_pd(xs + i));
+    __m256d acc = _mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3));
+    double s = lanes_sum(_mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1)));
+    for (; i < n; i++) s += xs[i];
+    return s;
+}
+
+TARGET_AVX2 static double product_avx2(const double* xs, size_t n) {
+    __m256d a0 = _mm256_set1_pd(1.0), a1 = a0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm256_mul_pd(a0, _mm256_loadu_pd(xs + i));
+        a1 = _mm256_mul_pd(a1, _mm256_loadu_pd(xs + i + 4));
+    }
+    __m256d acc = _mm256_mul_pd(a0, a1);
+    double p = lanes_product(_mm_mul_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1)));
+    for (; i < n; i++) p *= xs[i];
+    return p;
+}
+
+TARGET_AVX2 static double min_avx2(const double* xs, size_t n) {
+    __m256d a0 = _mm256_set1_pd(xs[0]), a1 = a0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm256_min_pd(a0, _mm256_loadu_pd(xs + i));
+        a1 = _mm256_min_pd(a1, _mm256_loadu_pd(xs + i + 4));
+    }
+    __m256d acc = _mm256_min_pd(a0, a1);
+    double m = lanes_min(_mm_min_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1)));
+    for (; i < n; i++) m = min2(m, xs[i]);
+    return m;
+}
+
+TARGET_AVX2 static double max_avx2(const double* xs, size_t n) {
+    __m256d a0 = _mm256_set1_pd(xs[0]), a1 = a0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm256_max_pd(a0, _mm256_loadu_pd(xs + i));
+        a1 = _mm256_max_pd(a1, _mm256_loadu_pd(xs + i + 4));
+    }
+    __m256d acc = _mm256_max_pd(a0, a1);
+    double m = lanes_max(_mm_max_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1)));
+    for (; i < n; i++) m = max2(m, xs[i]);
+    return m;
+}
+
+TARGET_AVX2 static double squared_deviations_avx2(const double* xs, size_t n, double mean) {
+    const __m256d mu = _mm256_set1_pd(mean);
+    __m256d a0 = _mm256_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(xs + i), mu);
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(xs + i + 4), mu);
+        __m256d d2 = _mm256_sub_pd(_mm256_loadu_pd(xs + i + 8), mu);
+        __m256d d3 = _mm256_sub_pd(_mm256_loadu_pd(xs + i + 12), mu);
+        a0 = _mm256_add_pd(a0, _mm256_mul_pd(d0, d0));
+        a1 = _mm256_add_pd(a1, _mm256_mul_pd(d1, d1));
+        a2 = _mm256_add_pd(a2, _mm256_mul_pd(d2, d2));
+        a3 = _mm256_add_pd(a3, _mm256_mul_pd(d3, d3));
+    }
+    __m256d acc = _mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3));
+    double s = lanes_sum(_mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1)));
+    for (; i < n; i++) s += (xs[i] - mean) * (xs[i] - mean);
+    return s;
+}
+#endif
+
+// ── Dispatch ──────────────────────────────────────────────────────────────
+const Stats::Kernels& Stats::kernels() {
+    static const Kernels chosen = [] {
+#if STATS_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return Kernels{"avx2", sum_avx2, product_avx2, min_avx2, max_avx2, squared_deviations_avx2};
+#endif
+#if STATS_SSE2
+        return Kernels{"sse2", sum_sse2, product_sse2, min_sse2, max_sse2, squared_deviations_sse2};
+#else
+        return Kernels{"scalar", sum_scalar, product_scalar, min_scalar, max_scalar, squared_deviations_scalar};
+#endif
+    }();
+    return chosen;
+}
+
+double Stats::sum(const double* xs, size_t n) { return kernels().sum(xs, n); }
+double Stats::product(const double* xs, size_t n) { return kernels().product(xs, n); }
+double Stats::mean(const double* xs, size_t n) { return kernels().sum(xs, n) / n; }
+double Stats::min(const double* xs, size_t n) { return kernels().min(xs, n); }
+double Stats::max(const double* xs, size_t n) { return kernels().max(xs, n); }
+const char* Stats::isa() { return kernels().isa; }
+
+double Stats::variance(const double* xs, size_t n) {
+    const Kernels& k = kernels();
+    double mean = 0, m2 = 0;
+    size_t count = 0;
+    for (size_t start = 0; start < n; start += BLOCK) {
+        size_t b = std::min(BLOCK, n - start);
+        double block_mean = k.sum(xs + start, b) / b;
+        double block_m2 = k.squared_deviations(xs + start, b, block_mean);
+        // Chan et al.: fold the block's mean and M2 into the totals so far
+        size_t total = count + b;
+        double delta = block_mean - mean;
+        mean += delta * b / total;
+        m2 += block_m2 + delta * delta * ((double)count * b / total);
+        count = total;
+    }
+    return m2 / n;
+}
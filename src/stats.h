@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+
+// ── Statistics kernels ────────────────────────────────────────────────────
+// Reductions over a contiguous buffer of doubles, behind Sum, Product, Mean,
+// Variance, StdDev and Min/Max of an array. A NumberArray is read in place;
+// an ordinary array's numbers are copied into a buffer first.
+//
+// On x86-64 the AVX2 kernels are used when the CPU has AVX2 (checked once,
+// on first use), SSE2 ones otherwise; other targets use plain loops. Sums
+// keep several partial sums per vector lane, so the last bits of a result
+// can differ from adding the numbers strictly in order.
+//
+// Variance makes one pass over memory: the buffer is taken in blocks that
+// fit in L1, each block's mean and squared deviations are computed while it
+// is cached, and blocks are merged into the running totals with Chan's
+// pairwise formula, which avoids the cancellation of sum-of-squares methods.
+class Stats {
+public:
+    static double sum(const double* xs, size_t n);
+    static double product(const double* xs, size_t n);
+    static double mean(const double* xs, size_t n);       // n > 0
+    static double variance(const double* xs, size_t n);   // population, n > 0
+    static double min(const double* xs, size_t n);       // n > 0
+    static double max(const double* xs, size_t n);       // n > 0
+    static const char* isa();                             // "avx2", "sse2" or "scalar"
+
+private:
+    static constexpr size_t BLOCK = 2048;   // doubles, 16 KB
+
+    struct Kernels {
+        const char* isa;
+        double (*sum)(const double* xs, size_t n);
+        double (*product)(const double* xs, size_t n);
+        double (*min)(const double* xs, size_t n);
+        double (*max)(const double* xs, size_t n);
+        double (*squared_deviations)(const double* xs, size_t n, double mean);
+    };
+    static const Kernels& kernels();
+};
@@ -0,0 +1,814 @@
+#include "transpiler.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+// ── Literals ──────────────────────────────────────────────────────────────
+// A C++ string literal for text; octal escapes keep every byte as it was
+static std::string quote(const std::string& text) {
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c >= 0x20 && c < 0x7f) {
+            out += (char)c;
+        } else {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\%03o", c);
+            out += buf;
+        }
+    }
+    return out + "\"";
+}
+
+static std::string number_literal(double n) {
+    if (std::isnan(n)) return "std::numeric_limits<double>::quiet_NaN()";
+    if (std::isinf(n))
+        return n < 0 ? "-std::numeric_limits<double>::infinity()" : "std::numeric_limits<double>::infinity()";
+    std::ostringstream text;
+    text << std::setprecision(17) << n;
+    std::string s = text.str();
+    if (s.find_first_of(".e") == std::string::npos) s += ".0";
+    return s;
+}
+
+static std::string token_name(TokenType op) {
+    switch (op) {
+        case TokenType::PLUS:          return "TokenType::PLUS";
+        case TokenType::MINUS:         return "TokenType::MINUS";
+        case TokenType::MULTIPLY:      return "TokenType::MULTIPLY";
+        case TokenType::DIVIDE:        return "TokenType::DIVIDE";
+        case TokenType::EQUAL:         return "TokenType::EQUAL";
+        case TokenType::NOT_EQUAL:     return "TokenType::NOT_EQUAL";
+        case TokenType::LESS_THAN:     return "TokenType::LESS_THAN";
+        case TokenType::GREATER_THAN:  return "TokenType::GREATER_THAN";
+        case TokenType::LESS_EQUAL:    return "TokenType::LESS_EQUAL";
+        case TokenType::GREATER_EQUAL: return "TokenType::GREATER_EQUAL";
+        default: return "(TokenType)" + std::to_string((int)op);
+    }
+}
+
+static bool is_statistic(Builtin id) {
+    return id == Builtin::Mean || id == Builtin::Sum || id == Builtin::Median ||
+           id == Builtin::StdDev || id == Builtin::Variance;
+}
+
+// ── Loading ───────────────────────────────────────────────────────────────
+static bool read_source(const std::string& path, std::string& source) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string content = buffer.str();
+    source.clear();
+    for (size_t i = 0; i < content.length(); i++) {
+        if (content[i] == '\r' && i + 1 < content.length() && content[i + 1] == '\n')
+            continue;
+        source += content[i];
+    }
+    return true;
+}
+
+Transpiler::Transpiler(const std::string& script_path) {
+    std::string source;
+    if (!read_source(script_path, source))
+        throw std::runtime_error("Could not open file: " + script_path);
+    units.emplace_back();
+    units[0].dir = std::filesystem::weakly_canonical(script_path).parent_path().string();
+    units[0].arena = std::make_unique<AstArena>();
+
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens, *units[0].arena);
+    units[0].program = parser.parse();
+
+    Interpreter folder;
+    Optimizer(folder, *units[0].arena).fold(units[0].program);
+    Resolver(global_table).resolve(units[0].program);
+    std::string dir = units[0].dir;
+    for (size_t i = 0; i < units[0].program.size(); i++)
+        collect(units[0].program[i].get(), dir);
+}
+
+// Loads the file an Import names, once per resolved path as the interpreter
+// does. A file that cannot be read or parsed becomes a unit that throws the
+// interpreter's error when it is imported.
+size_t Transpiler::load(const std::string& path, const std::string& dir) {
+    std::filesystem::path p(path);
+    std::string resolved = p.is_absolute() ? path
+        : std::filesystem::weakly_canonical(std::filesystem::path(dir) / p).string();
+    auto it = unit_index.find(resolved);
+    if (it != unit_index.end()) return it->second;
+
+    size_t index = units.size();
+    unit_index[resolved] = index;
+    units.emplace_back();
+    units[index].dir = std::filesystem::path(resolved).parent_path().string();
+    units[index].arena = std::make_unique<AstArena>();
+
+    std::string source;
+    std::ifstream file(resolved);
+    if (!file.is_open()) {
+        units[index].error = "Cannot open file for import: " + resolved;
+        return index;
+    }
+    file.close();
+    read_source(resolved, source);
+    try {
+        Lexer lexer(source);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, *units[index].arena);
+        units[index].program = parser.parse();
+        Interpreter folder;
+        Optimizer(folder, *units[index].arena).fold(units[index].program);
+    } catch (const std::exception& e) {
+        units[index].program.clear();
+        units[index].error = e.what();
+        return index;
+    }
+    Resolver(global_table).resolve(units[index].program);
+    // Collecting may add units, so units[index] is not held across it
+    std::string unit_dir = units[index].dir;
+    for (size_t i = 0; i < units[index].program.size(); i++)
+        collect(units[index].program[i].get(), unit_dir);
+    return index;
+}
+
+// Numbers every Func (nested ones too) and loads every imported file
+void Transpiler::collect(ASTNode* node, const std::string& dir) {
+    if (node->type == NodeType::FUNC_DEF) {
+        auto* func = static_cast<FuncDefNode*>(node);
+        func_index[func] = funcs.size();
+        funcs.push_back(func);
+        func_dirs.push_back(dir);
+    } else if (node->type == NodeType::IMPORT_STATEMENT) {
+        auto* imp = static_cast<ImportNode*>(node);
+        imports[imp] = load(imp->filepath, dir);
+    }
+    visit_children(node, [&](NodePtr& child) { collect(child.get(), dir); });
+}
+
+// True if a Break or Continue in stmts is outside every loop in them; it
+// then has to be reported at the function or file boundary
+static bool escapes_loop(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::BREAK_STATEMENT:
+        case NodeType::CONTINUE_STATEMENT:
+            return true;
+        case NodeType::WHILE_LOOP:
+        case NodeType::FOR_LOOP:
+        case NodeType::FUNC_DEF:
+            return false;
+        default:
+            break;
+    }
+    bool found = false;
+    visit_children(node, [&](NodePtr& child) { found = found || escapes_loop(child.get()); });
+    return found;
+}
+
+static bool escapes_loop(const std::vector<NodePtr>& stmts) {
+    for (const auto& stmt : stmts)
+        if (escapes_loop(stmt.get())) return true;
+    return false;
+}
+
+// ── Output ────────────────────────────────────────────────────────────────
+void Transpiler::emit(std::ostream& out) {
+    // Bodies first: writing them fills in the string and call site tables
+    std::ostringstream bodies;
+    for (FuncDefNode* func : funcs) emit_function(bodies, func);
+    for (size_t i = 0; i < units.size(); i++) emit_unit(bodies, i);
+
+    out << "// Generated by LANGUAGE --emit-cpp. Build it against the language_runtime\n";
+    out << "// library (language_add_executable in LANGUAGE's CMakeLists.txt).\n";
+    out << "#include \"runtime.h\"\n";
+    out << "#include <iostream>\n";
+    out << "#include <limits>\n\n";
+
+    if (!strings.empty())
+        out << "static Value* K;    // string literals, interned when main starts\n";
+    if (!sites.empty()) {
+        out << "static Runtime::CallSite sites[] = {\n";
+        for (const auto& name : sites) out << "    {" << quote(name) << ", 0, {}},\n";
+        out << "};\n";
+    }
+    out << "\n";
+
+    for (size_t i = 0; i < funcs.size(); i++)
+        out << "static Value f" << i << "(Runtime& rt, std::vector<Value>& args);    // "
+            << funcs[i]->name << "\n";
+    for (size_t i = 0; i < funcs.size(); i++) {
+        FuncDefNode* func = funcs[i];
+        size_t required = 0;
+        for (const auto& def : func->defaults)
+            if (!def) required++;
+        out << "static const Runtime::Function fd" << i << " = {" << quote(func->name) << ", "
+            << func->params.size() << ", " << required << ", f" << i << "};\n";
+    }
+    for (size_t i = 1; i < units.size(); i++)
+        out << "static void unit" << i << "(Runtime& rt);\n";
+    out << "\n" << bodies.str();
+
+    out << "int main() {\n";
+    if (!strings.empty()) {
+        out << "    Value strings[] = {\n";
+        for (const auto& text : strings)
+            out << "        intern(std::string_view(" << quote(text) << ", " << text.size() << ")),\n";
+        out << "    };\n";
+        out << "    K = strings;\n";
+    }
+    out << "    Runtime rt(" << global_table.names.size() << ");\n";
+    out << "    return rt.run(unit0);\n";
+    out << "}\n";
+}
+
+void Transpiler::emit_function(std::ostream& out, FuncDefNode* func) {
+    size_t index = func_index[func];
+    Scope fn;
+    fn.func = func;
+    fn.dir = func_dirs[index];
+    fn.escapes = escapes_loop(func->body);
+    if (fn.escapes) fn.indent = 2;
+    Scope* saved = scope;
+    scope = &fn;
+
+    line("Gc::safepoint();");
+    for (size_t i = 0; i < func->params.size(); i++) {
+        std::string param = "L[" + std::to_string(i) + "]";
+        line("if (args.size() > " + std::to_string(i) + ") Runtime::assign(" + param +
+             ") = std::move(args[" + std::to_string(i) + "]);");
+        if (func->defaults[i]) {
+            // Defaults are evaluated in the callee, after the earlier parameters
+            line("else {");
+            scope->indent++;
+            Operand def = expression(func->defaults[i].get());
+            line("Runtime::assign(" + param + ") = " + take(def) + ";");
+            scope->indent--;
+            line("}");
+        } else {
+            line("else throw std::runtime_error(" + quote("Missing argument: " + func->params[i]) + ");");
+        }
+    }
+    block(func->body);
+    if (func->body.empty() || func->body.back()->type != NodeType::RETURN_STATEMENT)
+        line("return Value();");
+    scope = saved;
+
+    out << "// Func " << func->name << "\n";
+    out << "static Value f" << index << "(Runtime& rt, std::vector<Value>& args) {\n";
+    out << "    (void)rt; (void)args;   // unused by some bodies\n";
+    out << "    Runtime::Slot L[" << std::max(func->num_locals, 1) << "];\n";
+    if (fn.escapes) out << "    try {\n";
+    if (fn.tail) out << "tail:\n";
+    out << fn.out.str();
+    if (fn.escapes) {
+        out << "    } catch (const Runtime::LoopEscape& escape) {\n";
+        out << "        Runtime::outside_loop(escape);\n";
+        out << "    }\n";
+    }
+    out << "}\n\n";
+}
+
+void Transpiler::emit_unit(std::ostream& out, size_t index) {
+    const Unit& unit = units[index];
+    Scope file;
+    file.dir = unit.dir;
+    file.escapes = escapes_loop(unit.program);
+    if (file.escapes) file.indent = 2;
+    Scope* saved = scope;
+    scope = &file;
+    if (!unit.error.empty()) fail(unit.error);
+    block(unit.program);
+    scope = saved;
+
+    out << "static void unit" << index << "(Runtime& rt) {\n";
+    out << "    (void)rt;\n";
+    if (file.escapes) out << "    try {\n";
+    out << file.out.str();
+    if (file.escapes) {
+        out << "    } catch (const Runtime::LoopEscape& escape) {\n";
+        out << "        Runtime::outside_loop(escape);\n";
+        out << "    }\n";
+    }
+    out << "}\n\n";
+}
+
+void Transpiler::line(const std::string& text) {
+    scope->out << std::string(scope->indent * 4, ' ') << text << "\n";
+}
+
+std::string Transpiler::temp(const char* prefix) {
+    return prefix + std::to_string(++scope->temps);
+}
+
+std::string Transpiler::take(const Operand& op) {
+    return op.owned ? "std::move(" + op.text + ")" : op.text;
+}
+
+std::string Transpiler::slot(const VarRef& ref) {
+    return (ref.local ? "L[" : "rt.globals[") + std::to_string(ref.slot) + "]";
+}
+
+// A read of a variable; an unassigned local falls back to the global
+std::string Transpiler::variable(const VarRef& ref, const std::string& name) {
+    int fallback = ref.local ? global_table.find(name) : -1;
+    return "rt.var(" + slot(ref) + ", " + std::to_string(fallback) + ", " + quote(name) + ")";
+}
+
+std::string Transpiler::string_constant(const std::string& text) {
+    auto it = string_index.find(text);
+    if (it == string_index.end()) {
+        it = string_index.emplace(text, strings.size()).first;
+        strings.push_back(text);
+    }
+    return "K[" + std::to_string(it->second) + "]";
+}
+
+void Transpiler::fail(const std::string& message) {
+    line("throw std::runtime_error(" + quote(message) + ");");
+}
+
+// ── Statements ────────────────────────────────────────────────────────────
+void Transpiler::block(const std::vector<NodePtr>& stmts) {
+    for (const auto& stmt : stmts) statement(stmt.get());
+}
+
+void Transpiler::statement(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::ASSIGNMENT: {
+            auto* assign = static_cast<AssignmentNode*>(node);
+            if (assign->value->type == NodeType::BINARY_OP) {
+                auto* bin = static_cast<BinaryOpNode*>(assign->value.get());
+                auto* var = static_cast<VariableNode*>(bin->left.get());
+                if (bin->op == TokenType::PLUS && bin->left->type == NodeType::VARIABLE &&
+                    var->ref.slot == assign->ref.slot && var->ref.local == assign->ref.local) {
+                    Operand left = expression(var);
+                    Operand right = expression(bin->right.get());
+                    line("Runtime::append(Runtime::assign(" + slot(assign->ref) + "), " + take(left) + ", " +
+                         right.text + ");");
+                    break;
+                }
+            }
+            Operand value = expression(assign->value.get());
+            line("Runtime::assign(" + slot(assign->ref) + ") = " + take(value) + ";");
+            break;
+        }
+
+        case NodeType::ARRAY_ASSIGN:
+        case NodeType::DICT_ASSIGN: {
+            const std::string* name;
+            const VarRef* ref;
+            ASTNode* key;
+            ASTNode* value;
+            if (node->type == NodeType::ARRAY_ASSIGN) {
+                auto* assign = static_cast<ArrayAssignNode*>(node);
+                name = &assign->name; ref = &assign->ref; key = assign->index.get(); value = assign->value.get();
+            } else {
+                auto* assign = static_cast<DictAssignNode*>(node);
+                name = &assign->name; ref = &assign->ref; key = assign->key.get(); value = assign->value.get();
+            }
+            line(variable(*ref, *name) + ";");     // must exist before the key is evaluated
+            Operand k = expression(key);
+            Operand v = expression(value);
+            line("Runtime::store_index(" + variable(*ref, *name) + ", " + k.text + ", " + take(v) + ", " +
+                 quote(*name) + ");");
+            break;
+        }
+
+        case NodeType::PRINT: {
+            Operand value = expression(static_cast<PrintNode*>(node)->expression.get());
+            line("std::cout << " + value.text + ".to_string() << std::endl;");
+            break;
+        }
+
+        case NodeType::WRITEFILE:
+        case NodeType::APPENDFILE: {
+            bool append = node->type == NodeType::APPENDFILE;
+            ASTNode* path = append ? static_cast<AppendFileNode*>(node)->path.get()
+                                   : static_cast<WriteFileNode*>(node)->path.get();
+            ASTNode* content = append ? static_cast<AppendFileNode*>(node)->content.get()
+                                      : static_cast<WriteFileNode*>(node)->content.get();
+            Operand p = expression(path);
+            Operand c = expression(content);
+            line("Runtime::write_file(" + p.text + ", " + c.text + ", " + (append ? "true" : "false") + ");");
+            break;
+        }
+
+        case NodeType::IF_STATEMENT: {
+            auto* if_node = static_cast<IfStatementNode*>(node);
+            int opened = 0;
+            std::string cond = condition(if_node->condition.get());
+            line("if (" + cond + ") {");
+            scope->indent++;
+            block(if_node->body);
+            scope->indent--;
+            for (auto& clause : if_node->elif_clauses) {
+                line("} else {");
+                scope->indent++;
+                opened++;
+                cond = condition(clause.condition.get());
+                line("if (" + cond + ") {");
+                scope->indent++;
+                block(clause.body);
+                scope->indent--;
+            }
+            if (!if_node->else_body.empty()) {
+                line("} else {");
+                scope->indent++;
+                block(if_node->else_body);
+                scope->indent--;
+            }
+            line("}");
+            for (; opened > 0; opened--) {
+                scope->indent--;
+                line("}");
+            }
+            break;
+        }
+
+        case NodeType::WHILE_LOOP: {
+            auto* while_node = static_cast<WhileLoopNode*>(node);
+            line("for (;;) {");
+            scope->indent++;
+            scope->loop_depth++;
+            line("Gc::safepoint();");
+            std::string cond = condition(while_node->condition.get());
+            line("if (!" + cond + ") break;");
+            block(while_node->body);
+            scope->loop_depth--;
+            scope->indent--;
+            line("}");
+            break;
+        }
+
+        case NodeType::FOR_LOOP: {
+            // As the tree engine: bounds read once, an unboxed counter, and
+            // the variable's slot only written
+            auto* for_node = static_cast<ForLoopNode*>(node);
+            Operand start = expression(for_node->start.get());
+            Operand end = expression(for_node->end.get());
+            std::string s = temp("s"), e = temp("e"), v = temp("v"), i = temp("i");
+            line("double " + s + " = " + start.text + ".number(), " + e + " = " + end.text + ".number();");
+            line("if (" + s + " <= " + e + ") {");
+            scope->indent++;
+            line("Value& " + v + " = Runtime::assign(" + slot(for_node->var_ref) + ");");
+            line("for (double " + i + " = " + s + "; " + i + " <= " + e + "; " + i + "++) {");
+            scope->indent++;
+            scope->loop_depth++;
+            line("Gc::safepoint();");
+            line(v + ".set_number(" + i + ");");
+            block(for_node->body);
+            scope->loop_depth--;
+            scope->indent--;
+            line("}");
+            scope->indent--;
+            line("}");
+            break;
+        }
+
+        case NodeType::FUNC_DEF:
+            line("rt.define(&fd" + std::to_string(func_index[static_cast<FuncDefNode*>(node)]) + ");");
+            break;
+
+        case NodeType::FUNC_CALL: {
+            auto* call_node = static_cast<FuncCallNode*>(node);
+            bool push = call_node->name == "Push", pop = call_node->name == "Pop";
+            if (push || pop) {
+                size_t argc = push ? 2 : 1;
+                if (call_node->args.size() != argc) {
+                    fail(call_node->name + " requires " + std::to_string(argc) +
+                         (push ? " arguments" : " argument"));
+                    break;
+                }
+                auto* var = dynamic_cast<VariableNode*>(call_node->args[0].get());
+                if (!var) {
+                    fail(call_node->name + " first argument must be a variable");
+                    break;
+                }
+                std::string arr = temp("r");
+                line("Value& " + arr + " = " + variable(var->ref, var->name) + ";");
+                line("Runtime::check_array(" + arr + ", " + quote(var->name) + ");");
+                if (push) {
+                    Operand value = expression(call_node->args[1].get());
+                    line("Runtime::push(" + arr + ", " + take(value) + ");");
+                } else {
+                    line("Runtime::pop(" + arr + ");");
+                }
+                break;
+            }
+            call(call_node, false);
+            break;
+        }
+
+        case NodeType::STRING_OP:
+            builtin(static_cast<StringOpNode*>(node));
+            break;
+
+        case NodeType::RETURN_STATEMENT: {
+            auto* ret = static_cast<ReturnNode*>(node);
+            if (!scope->func) {
+                // A top-level Return ends the file
+                expression(ret->value.get());
+                line("return;");
+                break;
+            }
+            Operand value = ret->tail_call ? call(static_cast<FuncCallNode*>(ret->value.get()), true)
+                                           : expression(ret->value.get());
+            line("return " + value.text + ";");
+            break;
+        }
+
+        case NodeType::BREAK_STATEMENT:
+        case NodeType::CONTINUE_STATEMENT: {
+            bool is_break = node->type == NodeType::BREAK_STATEMENT;
+            if (scope->loop_depth > 0)
+                line(is_break ? "break;" : "continue;");
+            else
+                line(std::string("throw Runtime::LoopEscape{") + (is_break ? "true" : "false") + "};");
+            break;
+        }
+
+        case NodeType::IMPORT_STATEMENT: {
+            std::string unit = std::to_string(imports[static_cast<ImportNode*>(node)]);
+            line("if (rt.first_import(" + unit + ")) unit" + unit + "(rt);");
+            break;
+        }
+
+        case NodeType::LANGPACK_IMPORT:
+            expression(node);
+            break;
+
+        case NodeType::TRY_CATCH: {
+            auto* tc = static_cast<TryCatchNode*>(node);
+            std::string error = temp("x");
+            line("try {");
+            scope->indent++;
+            block(tc->try_body);
+            scope->indent--;
+            line("} catch (const std::exception& " + error + ") {");
+            scope->indent++;
+            line("Runtime::assign(" + slot(tc->error_ref) + ") = Value(std::string(" + error + ".what()));");
+            block(tc->catch_body);
+            scope->indent--;
+            line("}");
+            break;
+        }
+
+        default:
+            fail("Unknown statement type");
+            break;
+    }
+}
+
+// ── Expressions ───────────────────────────────────────────────────────────
+Transpiler::Operand Transpiler::expression(ASTNode* node) {
+    switch (node->type) {
+        case NodeType::NUMBER:
+            return {"Value(" + number_literal(static_cast<NumberNode*>(node)->value) + ")", false};
+
+        case NodeType::STRING:
+            return {string_constant(static_cast<StringNode*>(node)->value.str()), false};
+
+        case NodeType::BOOLEAN:
+            return {static_cast<BooleanNode*>(node)->value ? "Value(true)" : "Value(false)", false};
+
+        case NodeType::NULL_LITERAL:
+            return {"Value()", false};
+
+        case NodeType::INTERP_STRING: {
+            auto* isn = static_cast<InterpStringNode*>(node);
+            std::string text = temp("s"), t = temp("t");
+            line("std::string " + text + ";");
+            for (auto& seg : isn->segments) {
+                if (seg.is_expr) {
+                    Operand part = expression(seg.expr.get());
+                    line(text + " += " + part.text + ".to_string();");
+                } else {
+                    line(text + ".append(" + quote(seg.literal) + ", " + std::to_string(seg.literal.size()) + ");");
+                }
+            }
+            line("Value " + t + "(std::move(" + text + "));");
+            return {t, true};
+        }
+
+        case NodeType::DICT: {
+            auto* dn = static_cast<DictNode*>(node);
+            std::string d = temp("d");
+            line("Rc<Dict> " + d + " = make_rc<Dict>();");
+            for (auto& [k, v] : dn->pairs) {
+                Operand key = expression(k.get());
+                Operand val = expression(v.get());
+                line("(*" + d + ")[Dict::key_of(" + key.text + ")] = " + take(val) + ";");
+            }
+            std::string t = temp("t");
+            line("Value " + t + "(std::move(" + d + "));");
+            return {t, true};
+        }
+
+        case NodeType::DICT_ACCESS: {
+            auto* da = static_cast<DictAccessNode*>(node);
+            std::string c = temp("t");
+            line("Value " + c + " = " + variable(da->ref, da->name) + ";");
+            Operand key = expression(da->key.get());
+            std::string t = temp("t");
+            line("Value " + t + " = Runtime::index(" + c + ", " + key.text + ", " + quote(da->name) + ");");
+            return {t, true};
+        }
+
+        case NodeType::ARRAY_ACCESS: {
+            auto* acc = static_cast<ArrayAccessNode*>(node);
+            std::string c = temp("t");
+            line("Value " + c + " = Runtime::check_array(" + variable(acc->ref, acc->name) + ", " +
+                 quote(acc->name) + ");");
+            Operand index = expression(acc->index.get());
+            std::string t = temp("t");
+            line("Value " + t + " = Runtime::element(" + c + ", " + index.text + ");");
+            return {t, true};
+        }
+
+        case NodeType::LANGPACK_IMPORT: {
+            // LANGPACKs are looked for next to the importing file
+            auto* lp = static_cast<LangpackImportNode*>(node);
+            line("rt.load_langpack(" + quote(lp->package_name) + ", " + quote(scope->dir) + ");");
+            return {"Value(0.0)", false};
+        }
+
+        case NodeType::INPUT: {
+            Operand prompt = expression(static_cast<InputNode*>(node)->prompt.get());
+            std::string t = temp("t");
+            line("Value " + t + " = Runtime::input(" + prompt.text + ");");
+            return {t, true};
+        }
+
+        case NodeType::READFILE: {
+            Operand path = expression(static_cast<ReadFileNode*>(node)->path.get());
+            std::string t = temp("t");
+            line("Value " + t + " = Runtime::read_file(" + path.text + ");");
+            return {t, true};
+        }
+
+        case NodeType::ARRAY: {
+            auto* arr = static_cast<ArrayNode*>(node);
+            std::string a = temp("a");
+            line("Rc<Array> " + a + " = make_rc<Array>();");
+            for (const auto& elem : arr->elements) {
+                Operand value = expression(elem.get());
+                line(a + "->push_back(" + take(value) + ");");
+            }
+            std::string t = temp("t");
+            line("Value " + t + "(std::move(" + a + "));");
+            return {t, true};
+        }
+
+        case NodeType::VARIABLE: {
+            auto* var = static_cast<VariableNode*>(node);
+            std::string t = temp("t");
+            line("Value " + t + " = " + variable(var->ref, var->name) + ";");
+            return {t, true};
+        }
+
+        case NodeType::BINARY_OP: {
+            auto* bin = static_cast<BinaryOpNode*>(node);
+            Operand left = expression(bin->left.get());
+            Operand right = expression(bin->right.get());
+            std::string t = temp("t");
+            line("Value " + t + " = Runtime::arithmetic(" + token_name(bin->op) + ", " + left.text + ", " +
+                 right.text + ");");
+            return {t, true};
+        }
+
+        case NodeType::LOGICAL_OP:
+        case NodeType::NOT_OP:
+            return {"Value(" + condition(node) + ")", false};
+
+        case NodeType::FUNC_CALL:
+            return call(static_cast<FuncCallNode*>(node), false);
+
+        case NodeType::STRING_OP:
+            return builtin(static_cast<StringOpNode*>(node));
+
+        default:
+            // Comparisons included: only conditions may hold them
+            fail("Invalid node type in expression");
+            return {"Value()", false};
+    }
+}
+
+// A bool with evaluate_condition's meaning for node
+std::string Transpiler::condition(ASTNode* node) {
+    std::string b = temp("b");
+    switch (node->type) {
+        case NodeType::COMPARISON: {
+            auto* cmp = static_cast<ComparisonNode*>(node);
+            Operand left = expression(cmp->left.get());
+            Operand right = expression(cmp->right.get());
+            line("bool " + b + " = Runtime::compare(" + token_name(cmp->op) + ", " + left.text + ", " +
+                 right.text + ");");
+            return b;
+        }
+
+        case NodeType::LOGICAL_OP: {
+            auto* log = static_cast<LogicalOpNode*>(node);
+            if (log->op != TokenType::AND && log->op != TokenType::OR) {
+                fail("Unknown logical operator");
+                return "false";
+            }
+            std::string left = condition(log->left.get());
+            line("bool " + b + " = " + left + ";");
+            line(std::string(log->op == TokenType::AND ? "if (" : "if (!") + b + ") {");
+            scope->indent++;
+            std::string right = condition(log->right.get());
+            line(b + " = " + right + ";");
+            scope->indent--;
+            line("}");
+            return b;
+        }
+
+        case NodeType::NOT_OP: {
+            std::string operand = condition(static_cast<NotOpNode*>(node)->operand.get());
+            line("bool " + b + " = !" + operand + ";");
+            return b;
+        }
+
+        default: {
+            Operand value = expression(node);
+            line("bool " + b + " = " + value.text + ".truthy();");
+            return b;
+        }
+    }
+}
+
+// A FuncCallNode, resolved in the interpreter's order: Random and the
+// statistics by name, then LANGPACK natives and Funcs through a call site.
+// tail: the operand of a Return the Resolver marked as a self tail call.
+Transpiler::Operand Transpiler::call(FuncCallNode* call_node, bool tail) {
+    const std::string& name = call_node->name;
+    if (name == "Random") {
+        std::string t = temp("t");
+        line("Value " + t + " = Runtime::random();");
+        return {t, true};
+    }
+    Builtin id = builtin_id(name);
+    if (is_statistic(id)) {
+        if (call_node->args.size() != 1) {
+            fail(name + " requires 1 argument");
+            return {"Value()", false};
+        }
+        Operand arr = expression(call_node->args[0].get());
+        std::string t = temp("t");
+        line("Value " + t + " = Runtime::statistic(Builtin::" + name + ", " + arr.text + ");");
+        return {t, true};
+    }
+
+    size_t site = sites.size();
+    sites.push_back(name);
+    std::string c = temp("c"), a = temp("a");
+    size_t argc = call_node->args.size();
+    line("Runtime::Target " + c + " = rt.resolve(sites[" + std::to_string(site) + "], " +
+         std::to_string(argc) + ");");
+    line("std::vector<Value> " + a + ";");
+    if (argc) line(a + ".reserve(" + std::to_string(argc) + ");");
+    for (auto& arg : call_node->args) {
+        Operand value = expression(arg.get());
+        line(a + ".push_back(" + take(value) + ");");
+    }
+    if (tail) {
+        // Still naming the running function: rebind its frame and loop
+        line("if (" + c + ".func == &fd" + std::to_string(func_index[scope->func]) + ") {");
+        scope->indent++;
+        line("args = std::move(" + a + ");");
+        line("for (Runtime::Slot& slot : L) slot = Runtime::Slot();");
+        line("goto tail;");
+        scope->indent--;
+        line("}");
+        scope->tail = true;
+    }
+    std::string t = temp("t");
+    line("Value " + t + " = rt.invoke(" + c + ", " + a + ");");
+    return {t, true};
+}
+
+// A built-in: target and arguments evaluated left to right, then one call
+Transpiler::Operand Transpiler::builtin(StringOpNode* op) {
+    Operand target = expression(op->target.get());
+    std::string a = temp("a");
+    line("std::vector<Value> " + a + ";");
+    if (!op->args.empty()) line(a + ".reserve(" + std::to_string(op->args.size()) + ");");
+    for (auto& arg : op->args) {
+        Operand value = expression(arg.get());
+        line(a + ".push_back(" + take(value) + ");");
+    }
+    std::string id = op->id == Builtin::Unknown ? "Unknown" : builtin_info(op->id).name;
+    std::string t = temp("t");
+    line("Value " + t + " = rt.builtin(Builtin::" + id + ", " + target.text + ", " + a + ");");
+    return {t, true};
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "parser.h"
+#include "resolver.h"
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Transpiler — `LANGUAGE --emit-cpp`. Turns a script, and every file it
+// Imports, into one C++ source file that runs on the Runtime (runtime.h);
+// built against the language_runtime library it is a standalone program
+// (language_add_executable in CMakeLists.txt).
+//
+// Units are folded and resolved exactly as the interpreter would, then each
+// Func becomes a C++ function over an array of local Slots and each file a
+// function run on its first Import. Expressions are flattened into
+// temporaries in evaluation order, so the program prints, fails and
+// short-circuits as the tree engine does; the saving is the dispatch and
+// the variable, call and constant lookups it no longer needs at run time.
+class Transpiler {
+public:
+    // Reads, folds and resolves script_path and its Imports; throws what
+    // running the script would for a missing or malformed main file
+    explicit Transpiler(const std::string& script_path);
+    void emit(std::ostream& out);
+
+private:
+    struct Unit {
+        std::string dir;                    // for Imports and LANGPACKs in it
+        std::unique_ptr<AstArena> arena;
+        std::vector<NodePtr> program;
+        std::string error;                  // set if it could not be loaded
+    };
+    std::vector<Unit> units;                // units[0] is the script
+    std::map<std::string, size_t> unit_index;   // resolved import path → unit
+    std::map<ImportNode*, size_t> imports;
+    GlobalTable global_table;
+
+    std::vector<FuncDefNode*> funcs;
+    std::vector<std::string> func_dirs;     // of the file each Func is in
+    std::map<FuncDefNode*, size_t> func_index;
+    std::vector<std::string> strings;       // K[]: string literals, interned once
+    std::map<std::string, size_t> string_index;
+    std::vector<std::string> sites;         // call sites of user and LANGPACK functions
+
+    // What an expression left behind: a temporary the caller may move
+    // from, or an expression to copy (a literal, a constant)
+    struct Operand {
+        std::string text;
+        bool owned;
+    };
+
+    // The function or file being written
+    struct Scope {
+        std::ostringstream out;
+        int indent = 1;
+        FuncDefNode* func = nullptr;        // nullptr at file level
+        std::string dir;                    // of the file it is in
+        int loop_depth = 0;
+        bool escapes = false;               // has a Break/Continue outside a loop
+        bool tail = false;                  // has a self tail call
+        int temps = 0;
+    };
+    Scope* scope = nullptr;
+
+    size_t load(const std::string& path, const std::string& dir);
+    void collect(ASTNode* node, const std::string& dir);
+
+    void emit_function(std::ostream& out, FuncDefNode* func);
+    void emit_unit(std::ostream& out, size_t index);
+
+    void line(const std::string& text);
+    std::string temp(const char* prefix);
+    static std::string take(const Operand& op);
+    std::string variable(const VarRef& ref, const std::string& name);
+    std::string slot(const VarRef& ref);
+    std::string string_constant(const std::string& text);
+
+    void block(const std::vector<NodePtr>& stmts);
+    void statement(ASTNode* node);
+    Operand expression(ASTNode* node);
+    std::string condition(ASTNode* node);
+    Operand call(FuncCallNode* call, bool tail);
+    Operand builtin(StringOpNode* op);
+    void fail(const std::string& message);
+};
@@ -0,0 +1,55 @@
+#include "value.h"
+#include <unordered_map>
+
+// ── Intern table ──────────────────────────────────────────────────────────
+// Weak: entries point at live StrObjs without owning them, and a StrObj
+// removes its own entry when its last reference goes. Keys view the
+// StrObj's text, which never changes once built. Leaked on purpose so it
+// outlives any Value destroyed during static teardown.
+using InternTable = std::unordered_map<std::string_view, RcBox<StrObj>*>;
+
+static InternTable& intern_table() {
+    static InternTable* table = new InternTable();
+    return *table;
+}
+
+Str intern(std::string_view text) {
+    InternTable& table = intern_table();
+    auto it = table.find(text);
+    if (it != table.end()) return Str::share(it->second);
+    auto* box = new RcBox<StrObj>(std::string(text));
+    box->value.interned = true;
+    table.emplace(box->value.text, box);
+    return Str(box);
+}
+
+Str intern(Str s) {
+    if (s->interned) return s;
+    InternTable& table = intern_table();
+    auto it = table.find(s->text);
+    if (it != table.end()) return Str::share(it->second);
+    s->interned = true;
+    table.emplace(s->text, s.raw());
+    return s;
+}
+
+// ── Sharing across threads ────────────────────────────────────────────────
+void Value::share_across_threads() const {
+    if (!is_heap() || obj->atomic) return;   // already shared, or cyclic
+    obj->atomic = true;
+    if (GcLink* link = gc_link()) Gc::untrack(link);   // live for good
+    if (is_string()) {
+        if (str_box()->value.interned) obj->retain();
+    } else if (is_array()) {
+        for (const Value& elem : *array()) elem.share_across_threads();
+    } else if (is_dict()) {
+        for (const auto& [key, val] : *dict()) {
+            Value(key).share_across_threads();
+            val.share_across_threads();
+        }
+    }
+}
+
+StrObj::~StrObj() {
+    if (interned) intern_table().erase(text);
+}
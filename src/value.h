@@ -0,0 +1,462 @@
+#pragma once
+#include "gc.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ── Reference counting ────────────────────────────────────────────────────
+// Strings, arrays and dicts live in an RcBox: the payload plus an intrusive
+// count, so a Value needs one pointer to reach them rather than a
+// shared_ptr's two.
+// The interpreter runs on one thread, so counts are plain loads and stores
+// with no locked instructions. A box another thread can reach is switched
+// to atomic counting first (Value::share_across_threads), for good.
+struct RcBase {
+    std::atomic<uint32_t> refs{1};
+    bool atomic = false;   // set before the box is published to another thread
+
+    void retain() {
+        if (atomic) refs.fetch_add(1, std::memory_order_relaxed);
+        else refs.store(refs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    // True if that was the last reference
+    bool release() {
+        if (atomic) return refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        uint32_t n = refs.load(std::memory_order_relaxed) - 1;
+        refs.store(n, std::memory_order_relaxed);
+        return n == 0;
+    }
+    uint32_t count() const { return refs.load(std::memory_order_relaxed); }
+    bool unique() const { return count() == 1; }
+};
+
+// Payloads that can hold Values, and so form cycles (specialised below)
+template <typename T>
+struct gc_tracked : std::false_type {};
+
+template <typename T, bool = gc_tracked<T>::value>
+struct RcBox : RcBase {
+    T value;
+    template <typename... Args>
+    explicit RcBox(Args&&... args) : value(std::forward<Args>(args)...) {}
+};
+
+// Arrays and dicts are also linked into the cycle collector's list (gc.h)
+class Dict;
+template <typename T>
+struct RcBox<T, true> : RcBase, GcLink {
+    T value;
+    template <typename... Args>
+    explicit RcBox(Args&&... args) : value(std::forward<Args>(args)...) {
+        Gc::track(this, std::is_same<T, Dict>::value);
+    }
+    ~RcBox() { Gc::untrack(this); }
+    RcBox(const RcBox&) = delete;
+    RcBox& operator=(const RcBox&) = delete;
+};
+
+// Owning handle to an RcBox<T>; used while building a container before it
+// is handed to a Value
+template <typename T>
+class Rc {
+public:
+    Rc() = default;
+    explicit Rc(RcBox<T>* b) : box(b) {}            // adopts the initial reference
+    Rc(const Rc& o) : box(o.box) { if (box) box->retain(); }
+    Rc(Rc&& o) noexcept : box(o.box) { o.box = nullptr; }
+    Rc& operator=(Rc o) noexcept { std::swap(box, o.box); return *this; }
+    ~Rc() {
+        if (box && box->release()) delete box;
+    }
+
+    // Takes a new reference to a box someone else already owns
+    static Rc share(RcBox<T>* b) {
+        b->retain();
+        return Rc(b);
+    }
+
+    T* get() const        { return box ? &box->value : nullptr; }
+    T* operator->() const { return &box->value; }
+    T& operator*() const  { return box->value; }
+    explicit operator bool() const { return box != nullptr; }
+
+    RcBox<T>* raw() const { return box; }
+    RcBox<T>* detach() { RcBox<T>* b = box; box = nullptr; return b; }
+
+private:
+    RcBox<T>* box = nullptr;
+};
+
+template <typename T, typename... Args>
+Rc<T> make_rc(Args&&... args) {
+    return Rc<T>(new RcBox<T>(std::forward<Args>(args)...));
+}
+
+// ── Strings ───────────────────────────────────────────────────────────────
+// String payloads are immutable once shared, so copies share one StrObj;
+// only a Value holding the sole reference may append to it (Value::append).
+// Literals and dict keys are interned: the table holds one StrObj per
+// distinct text, so two interned strings are equal exactly when they are
+// the same object.
+struct StrObj {
+    std::string text;
+    bool interned = false;
+
+    // Computed on first use and cached; dict keys hash once
+    size_t hash() const {
+        if (!hashed) { hash_value = hash_text(text); hashed = true; }
+        return hash_value;
+    }
+    static size_t hash_text(std::string_view s) { return std::hash<std::string_view>()(s); }
+
+    // For the sole owner of a string that is not interned, see Value::append
+    void append(std::string_view tail) {
+        text.append(tail);
+        hashed = false;
+    }
+
+    explicit StrObj(std::string s) : text(std::move(s)) {}
+    StrObj(const StrObj&) = delete;
+    StrObj& operator=(const StrObj&) = delete;
+    ~StrObj();                       // an interned string leaves the table here
+
+private:
+    mutable size_t hash_value = 0;
+    mutable bool hashed = false;
+};
+using Str = Rc<StrObj>;
+
+Str intern(std::string_view text);   // the table's StrObj for this text
+Str intern(Str s);                   // s itself if it becomes the canonical copy
+
+inline bool str_equal(const StrObj& a, const StrObj& b) {
+    if (&a == &b) return true;
+    if (a.interned && b.interned) return false;
+    return a.text == b.text;
+}
+
+// ── Value ─────────────────────────────────────────────────────────────────
+struct Value;
+class Dict;
+using Array = std::vector<Value>;
+using NumberArray = std::vector<double>;   // NumberArray(n), ToNumberArray(arr)
+template <> struct gc_tracked<Array> : std::true_type {};
+template <> struct gc_tracked<Dict> : std::true_type {};
+
+// 16 bytes: a type tag plus either an immediate (number, boolean) or one
+// pointer to a reference-counted string, array, dict or number array.
+// Copying a heap Value shares it, as before.
+// A NUMBER_ARRAY holds bare doubles, 8 bytes each rather than a Value's 16.
+// It indexes, prints and counts like an array; is_array() is false for it,
+// since array() does not apply.
+struct Value {
+    // Immediates first, so is_heap() is one comparison
+    enum class Type : uint8_t { NUMBER, BOOLEAN, NULL_TYPE, STRING, ARRAY, DICT, NUMBER_ARRAY } type;
+
+    Value() : type(Type::NULL_TYPE), bits(0) {}  // default = Null
+    Value(double n) : type(Type::NUMBER), num(n) {}
+    Value(bool b) : type(Type::BOOLEAN), bits(0) { flag = b; }
+    Value(const std::string& s) : type(Type::STRING), obj(new RcBox<StrObj>(s)) {}
+    Value(std::string&& s) : type(Type::STRING), obj(new RcBox<StrObj>(std::move(s))) {}
+    Value(const char* s) : type(Type::STRING), obj(new RcBox<StrObj>(s)) {}
+    Value(Str s) : type(Type::STRING), obj(s.detach()) {}
+    Value(Rc<Array> a) : type(Type::ARRAY), obj(a.detach()) {}
+    Value(Rc<NumberArray> a) : type(Type::NUMBER_ARRAY), obj(a.detach()) {}
+    Value(Rc<Dict> d);
+
+    Value(const Value& o) : type(o.type), bits(o.bits) { retain(); }
+    Value(Value&& o) noexcept : type(o.type), bits(o.bits) { o.type = Type::NULL_TYPE; }
+    Value& operator=(const Value& o) {
+        if (this != &o) { Value tmp(o); swap(tmp); }
+        return *this;
+    }
+    Value& operator=(Value&& o) noexcept {
+        if (this != &o) { Value tmp(std::move(o)); swap(tmp); }
+        return *this;
+    }
+    ~Value() { release(); }
+
+    static Value make_null() { return Value(); }
+
+    bool is_number()  const { return type == Type::NUMBER; }
+    bool is_string()  const { return type == Type::STRING; }
+    bool is_boolean() const { return type == Type::BOOLEAN; }
+    bool is_array()   const { return type == Type::ARRAY; }
+    bool is_dict()    const { return type == Type::DICT; }
+    bool is_number_array() const { return type == Type::NUMBER_ARRAY; }
+    bool is_null()    const { return type == Type::NULL_TYPE; }
+    bool is_heap()    const { return type >= Type::STRING; }
+
+    // Typed reads. A value of another type reads as 0 / false / "" / null,
+    // the same defaults the old all-fields-present layout gave.
+    double number() const  { return type == Type::NUMBER ? num : 0; }
+    bool boolean() const   { return type == Type::BOOLEAN && flag; }
+    const std::string& str() const {
+        static const std::string empty;
+        return type == Type::STRING ? str_box()->value.text : empty;
+    }
+    Array* array() const { return type == Type::ARRAY ? &static_cast<RcBox<Array>*>(obj)->value : nullptr; }
+    NumberArray* number_array() const {
+        return type == Type::NUMBER_ARRAY ? &static_cast<RcBox<NumberArray>*>(obj)->value : nullptr;
+    }
+    inline Dict* dict() const;
+
+    // Shares the StrObj of a string value (null handle otherwise)
+    Str str_ref() const { return type == Type::STRING ? Str::share(str_box()) : Str(); }
+    bool str_equals(const Value& o) const { return str_equal(str_box()->value, o.str_box()->value); }
+
+    inline bool truthy() const;
+    inline std::string to_string() const;
+
+    // Appends tail's printed form to this string in place, if this Value
+    // holds the only reference to a string that is not interned. False,
+    // and nothing changes, otherwise.
+    inline bool append(const Value& tail);
+    bool same_object(const Value& o) const { return type == o.type && is_heap() && obj == o.obj; }
+
+    // Switches this value and everything reachable from it to atomic
+    // reference counts, so copies of it may be made and dropped on another
+    // thread. Call before handing it over; elements stored into it later
+    // are not covered. Interned strings reached this way are pinned, since
+    // the intern table belongs to the interpreter's thread.
+    void share_across_threads() const;
+
+    // The cycle collector's link of an array or dict, nullptr otherwise
+    inline GcLink* gc_link() const;
+
+    // Overwrite with a number in place: no temporary, and no refcount
+    // traffic when the old value was a number too
+    void set_number(double n) {
+        if (is_heap()) release();
+        type = Type::NUMBER;
+        num = n;
+    }
+
+    void swap(Value& o) noexcept {
+        std::swap(type, o.type);
+        std::swap(bits, o.bits);
+    }
+
+private:
+    union {
+        uint64_t bits;      // whole payload, for copies
+        double num;
+        bool flag;
+        RcBase* obj;
+    };
+
+    RcBox<StrObj>* str_box() const { return static_cast<RcBox<StrObj>*>(obj); }
+
+    void retain() {
+        if (is_heap()) obj->retain();
+    }
+    inline void release();
+};
+
+static_assert(sizeof(Value) == 16, "Value should stay a tag plus one word");
+
+// ── Dict ──────────────────────────────────────────────────────────────────
+// Insertion-ordered hash map behind every dictionary, laid out like
+// CPython's compact dict: entries sit densely in insertion order and a
+// separate open-addressing table of 32-bit indices (linear probing, kept
+// under 2/3 full) points into them. Removing a key leaves a dead entry that
+// iteration skips; dead entries are dropped on the next rehash.
+// Stored keys are always interned, so a lookup with an interned key (a
+// literal, or a key read back out of another dict) matches by pointer.
+class Dict {
+public:
+    using Entry = std::pair<Str, Value>;   // dead entries have a null key
+
+    template <typename E>
+    class Iter {
+    public:
+        Iter(E* p, E* end) : p(p), end(end) { skip(); }
+        E& operator*() const  { return *p; }
+        E* operator->() const { return p; }
+        Iter& operator++() { ++p; skip(); return *this; }
+        bool operator==(const Iter& o) const { return p == o.p; }
+        bool operator!=(const Iter& o) const { return p != o.p; }
+    private:
+        E* p;
+        E* end;
+        void skip() { while (p != end && !p->first) ++p; }
+    };
+    using iterator = Iter<Entry>;
+    using const_iterator = Iter<const Entry>;
+
+    // Key a Value indexes with: strings as themselves, anything else by its
+    // printed form, as dict keys always have been
+    static Str key_of(const Value& key) {
+        return key.is_string() ? key.str_ref() : intern(key.to_string());
+    }
+
+    Value* find(const Str& key) {
+        uint32_t i = lookup(key->hash(), [&](const StrObj& k) { return str_equal(k, *key); });
+        return i == EMPTY ? nullptr : &entries[i].second;
+    }
+    Value* find(std::string_view key) {
+        uint32_t i = lookup(StrObj::hash_text(key), [&](const StrObj& k) { return k.text == key; });
+        return i == EMPTY ? nullptr : &entries[i].second;
+    }
+    bool has(std::string_view key) { return find(key) != nullptr; }
+
+    Value& operator[](const Str& key) {
+        if (Value* v = find(key)) return *v;
+        return insert(intern(key));
+    }
+    Value& operator[](std::string_view key) {
+        if (Value* v = find(key)) return *v;
+        return insert(intern(key));
+    }
+
+    bool erase(std::string_view key) {
+        uint32_t i = lookup(StrObj::hash_text(key), [&](const StrObj& k) { return k.text == key; });
+        if (i == EMPTY) return false;
+        entries[i] = Entry();   // index slot keeps pointing here; probes walk past it
+        live--;
+        return true;
+    }
+
+    size_t size() const { return live; }
+    bool empty() const  { return live == 0; }
+    // Heap bytes behind the entries and index, for GcStats
+    size_t bytes() const { return entries.capacity() * sizeof(Entry) + index.capacity() * sizeof(uint32_t); }
+
+    iterator begin() { return {entries.data(), entries.data() + entries.size()}; }
+    iterator end()   { return {entries.data() + entries.size(), entries.data() + entries.size()}; }
+    const_iterator begin() const { return {entries.data(), entries.data() + entries.size()}; }
+    const_iterator end() const   { return {entries.data() + entries.size(), entries.data() + entries.size()}; }
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    std::vector<Entry> entries;      // insertion order, including dead ones
+    std::vector<uint32_t> index;     // power-of-two sized, EMPTY or an entry number
+    size_t live = 0;
+
+    template <typename Match>
+    uint32_t lookup(size_t hash, Match match) const {
+        if (index.empty()) return EMPTY;
+        size_t mask = index.size() - 1;
+        for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            uint32_t i = index[slot];
+            if (i == EMPTY) return EMPTY;
+            const Str& k = entries[i].first;
+            if (k && k->hash() == hash && match(*k)) return i;
+        }
+    }
+
+    Value& insert(Str key) {
+        if ((entries.size() + 1) * 3 > index.size() * 2) rehash(live + 1);
+        size_t mask = index.size() - 1;
+        size_t slot = key->hash() & mask;
+        while (index[slot] != EMPTY) slot = (slot + 1) & mask;
+        index[slot] = (uint32_t)entries.size();
+        entries.emplace_back(std::move(key), Value());
+        live++;
+        return entries.back().second;
+    }
+
+    // Drops dead entries and rebuilds the index with room for `want` keys
+    void rehash(size_t want) {
+        if (live != entries.size()) {
+            size_t out = 0;
+            for (size_t i = 0; i < entries.size(); i++)
+                if (entries[i].first) entries[out++] = std::move(entries[i]);
+            entries.resize(out);
+        }
+        size_t cap = 8;
+        while (want * 3 > cap * 2) cap *= 2;
+        index.assign(cap, EMPTY);
+        size_t mask = cap - 1;
+        for (size_t i = 0; i < entries.size(); i++) {
+            size_t slot = entries[i].first->hash() & mask;
+            while (index[slot] != EMPTY) slot = (slot + 1) & mask;
+            index[slot] = (uint32_t)i;
+        }
+    }
+};
+
+// ── Value members that need Dict ──────────────────────────────────────────
+inline Value::Value(Rc<Dict> d) : type(Type::DICT), obj(d.detach()) {}
+
+inline Dict* Value::dict() const {
+    return type == Type::DICT ? &static_cast<RcBox<Dict>*>(obj)->value : nullptr;
+}
+
+inline GcLink* Value::gc_link() const {
+    if (type == Type::ARRAY) return static_cast<RcBox<Array>*>(obj);
+    if (type == Type::DICT)  return static_cast<RcBox<Dict>*>(obj);
+    return nullptr;
+}
+
+inline bool Value::truthy() const {
+    if (is_null())    return false;
+    if (is_boolean()) return flag;
+    if (is_number())  return num != 0;
+    if (is_string())  return !str().empty();
+    if (is_array())   return !array()->empty();
+    if (is_number_array()) return !number_array()->empty();
+    if (is_dict())    return !dict()->empty();
+    return false;
+}
+
+inline std::string Value::to_string() const {
+    if (is_null())    return "Null";
+    if (is_string())  return str();
+    if (is_boolean()) return flag ? "True" : "False";
+    if (is_array()) {
+        const Array& items = *array();
+        std::string s = "[";
+        for (size_t i = 0; i < items.size(); i++) {
+            s += items[i].to_string();
+            if (i + 1 < items.size()) s += ", ";
+        }
+        return s + "]";
+    }
+    if (is_number_array()) {
+        const NumberArray& items = *number_array();
+        std::string s = "[";
+        for (size_t i = 0; i < items.size(); i++) {
+            s += Value(items[i]).to_string();
+            if (i + 1 < items.size()) s += ", ";
+        }
+        return s + "]";
+    }
+    if (is_dict()) {
+        std::string s = "{";
+        bool first = true;
+        for (auto& [k, v] : *dict()) {
+            if (!first) s += ", ";
+            s += "\"" + k->text + "\": " + v.to_string();
+            first = false;
+        }
+        return s + "}";
+    }
+    if (num == (int)num) return std::to_string((int)num);
+    return std::to_string(num);
+}
+
+inline bool Value::append(const Value& tail) {
+    if (!is_string() || !obj->unique()) return false;
+    StrObj& s = str_box()->value;
+    if (s.interned) return false;
+    if (tail.is_string()) s.append(tail.str());
+    else s.append(tail.to_string());
+    return true;
+}
+
+inline void Value::release() {
+    if (!is_heap() || !obj->release()) return;
+    switch (type) {
+        case Type::STRING: delete str_box(); break;
+        case Type::ARRAY:  delete static_cast<RcBox<Array>*>(obj); break;
+        case Type::DICT:   delete static_cast<RcBox<Dict>*>(obj); break;
+        case Type::NUMBER_ARRAY: delete static_cast<RcBox<NumberArray>*>(obj); break;
+        default: break;
+    }
+}
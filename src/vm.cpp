@@ -0,0 +1,405 @@
+#include "vm.h"
+#include <iostream>
+#if defined(USE_JIT)
+  #include "jit.h"
+#endif
+
+// Threaded dispatch where the compiler supports labels-as-values,
+// a plain switch everywhere else
+#if defined(__GNUC__) || defined(__clang__)
+  #define LANG_VM_COMPUTED_GOTO 1
+#endif
+
+void VM::run_program(const std::vector<NodePtr>& program) {
+    programs.push_back(compiler.compile_program(program));
+    run(*programs.back());
+}
+
+Value VM::call(FuncDefNode* func, std::vector<Value>& args) {
+    interp.check_arity(func, args.size());
+#if defined(USE_JIT)
+    Value native_result;
+    if (interp.jit->call(func, args, native_result)) return native_result;
+#endif
+    interp.push_frame(func, args);
+    Value result;
+    try {
+        result = run(function_chunk(func));
+    } catch (...) {
+        interp.frames.pop_back();
+        throw;
+    }
+    interp.frames.pop_back();
+    return result;
+}
+
+// Runs a resolved CALL target with already evaluated arguments
+Value VM::invoke(FuncCallNode* call, std::vector<Value>& args) {
+    if (call->cache_generation != interp.call_generation) interp.resolve_call(call);
+    if (call->target == FuncCallNode::Target::NATIVE) return (*call->native)(args);
+    if (call->target != FuncCallNode::Target::USER)
+        throw std::runtime_error("Undefined function: " + call->name);
+    return this->call(call->func, args);
+}
+
+// Function bodies are compiled on their first call
+const Chunk& VM::function_chunk(FuncDefNode* func) {
+    auto it = function_chunks.find(func);
+    if (it == function_chunks.end())
+        it = function_chunks.emplace(func, compiler.compile_function(func)).first;
+    return *it->second;
+}
+
+Value VM::run(const Chunk& chunk) {
+    Gc::safepoint();
+    const size_t base = stack.size();
+    std::vector<Handler> handlers;
+    const Instr* const code = chunk.code.data();
+    const Instr* ip = code;
+    const Instr* in = nullptr;
+    // Top-level chunks never touch frame slots, so this may be null there
+    Interpreter::VarSlot* locals =
+        interp.frames.empty() ? nullptr : interp.frames.back().locals.data();
+
+    auto pop = [&]() {
+        Value v = std::move(stack.back());
+        stack.pop_back();
+        return v;
+    };
+
+    // Each handler keeps its locals in a block and dispatches after it
+    // closes: a computed goto out of a scope does not run destructors.
+#ifdef LANG_VM_COMPUTED_GOTO
+  #define VM_LABEL(name) &&op_##name,
+  #define VM_CASE(name) op_##name
+  #define VM_NEXT() do { in = ip++; goto *dispatch_table[(int)in->op]; } while (0)
+    static void* const dispatch_table[] = { LANG_OPCODES(VM_LABEL) };
+#else
+  #define VM_CASE(name) case OpCode::name
+  #define VM_NEXT() break
+#endif
+
+    for (;;) {
+        try {
+#ifdef LANG_VM_COMPUTED_GOTO
+            VM_NEXT();
+#else
+            for (;;) {
+            in = ip++;
+            switch (in->op) {
+#endif
+            VM_CASE(CONST): {
+                stack.push_back(chunk.constants[in->a]);
+            }
+            VM_NEXT();
+
+            VM_CASE(POP): {
+                stack.resize(stack.size() - in->a);
+            }
+            VM_NEXT();
+
+            VM_CASE(LOAD_LOCAL): {
+                Interpreter::VarSlot& slot = locals[in->a];
+                if (slot.defined) {
+                    stack.push_back(slot.value);
+                } else {
+                    // Not assigned yet in this call — may still name a global
+                    VarRef ref;
+                    ref.slot = in->a;
+                    ref.local = true;
+                    const std::string& name = chunk.names[in->b];
+                    Value* v = interp.find_variable(ref, name);
+                    if (!v) throw std::runtime_error("Undefined variable: " + name);
+                    stack.push_back(*v);
+                }
+            }
+            VM_NEXT();
+
+            VM_CASE(LOAD_GLOBAL): {
+                Interpreter::VarSlot& slot = interp.globals[in->a];
+                if (!slot.defined)
+                    throw std::runtime_error("Undefined variable: " + chunk.names[in->b]);
+                stack.push_back(slot.value);
+            }
+            VM_NEXT();
+
+            VM_CASE(STORE_LOCAL): {
+                Interpreter::VarSlot& slot = locals[in->a];
+                slot.value = pop();
+                slot.defined = true;
+            }
+            VM_NEXT();
+
+            VM_CASE(STORE_GLOBAL): {
+                Interpreter::VarSlot& slot = interp.globals[in->a];
+                slot.value = pop();
+                slot.defined = true;
+            }
+            VM_NEXT();
+
+            VM_CASE(APPEND_LOCAL): {
+                Value right = pop();
+                Value left = pop();
+                Interpreter::VarSlot& slot = locals[in->a];
+                if (left.is_number() && right.is_number()) slot.value = Value(left.number() + right.number());
+                else Interpreter::append_to(slot.value, std::move(left), right);
+                slot.defined = true;
+            }
+            VM_NEXT();
+
+            VM_CASE(APPEND_GLOBAL): {
+                Value right = pop();
+                Value left = pop();
+                Interpreter::VarSlot& slot = interp.globals[in->a];
+                if (left.is_number() && right.is_number()) slot.value = Value(left.number() + right.number());
+                else Interpreter::append_to(slot.value, std::move(left), right);
+                slot.defined = true;
+            }
+            VM_NEXT();
+
+            VM_CASE(INDEX): {
+                Value key = pop();
+                Value& container = stack.back();
+                Value scratch;
+                Value elem = Interpreter::lookup(container, key, chunk.names[in->b], scratch);
+                container = std::move(elem);
+            }
+            VM_NEXT();
+
+            VM_CASE(STORE_INDEX_LOCAL):
+            VM_CASE(STORE_INDEX_GLOBAL): {
+                VarRef ref;
+                ref.slot = in->a;
+                ref.local = in->op == OpCode::STORE_INDEX_LOCAL;
+                const std::string& name = chunk.names[in->b];
+                Value val = pop();
+                Value key = pop();
+                Value* container = interp.find_variable(ref, name);
+                if (!container) throw std::runtime_error("Undefined variable: " + name);
+                Interpreter::store(*container, key, std::move(val), name);
+            }
+            VM_NEXT();
+
+            VM_CASE(ADD): {
+                Value right = pop();
+                Value& left = stack.back();
+                if (left.is_number() && right.is_number()) left = Value(left.number() + right.number());
+                else left = Interpreter::arithmetic(TokenType::PLUS, left, right);
+            }
+            VM_NEXT();
+
+            VM_CASE(SUB): {
+                Value right = pop();
+                Value& left = stack.back();
+                if (left.is_number() && right.is_number()) left = Value(left.number() - right.number());
+                else left = Interpreter::arithmetic(TokenType::MINUS, left, right);
+            }
+            VM_NEXT();
+
+            VM_CASE(MUL): {
+                Value right = pop();
+                Value& left = stack.back();
+                if (left.is_number() && right.is_number()) left = Value(left.number() * right.number());
+                else left = Interpreter::arithmetic(TokenType::MULTIPLY, left, right);
+            }
+            VM_NEXT();
+
+            VM_CASE(DIV): {
+                Value right = pop();
+                Value& left = stack.back();
+                left = Interpreter::arithmetic(TokenType::DIVIDE, left, right);
+            }
+            VM_NEXT();
+
+#define VM_COMPARE(name, token) \
+            VM_CASE(name): { \
+                Value right = pop(); \
+                Value& left = stack.back(); \
+                left = Value(Interpreter::compare(TokenType::token, left, right)); \
+            } \
+            VM_NEXT();
+            VM_COMPARE(EQ, EQUAL)
+            VM_COMPARE(NE, NOT_EQUAL)
+            VM_COMPARE(LT, LESS_THAN)
+            VM_COMPARE(GT, GREATER_THAN)
+            VM_COMPARE(LE, LESS_EQUAL)
+            VM_COMPARE(GE, GREATER_EQUAL)
+#undef VM_COMPARE
+
+            VM_CASE(NOT): {
+                stack.back() = Value(!stack.back().truthy());
+            }
+            VM_NEXT();
+
+            VM_CASE(JUMP): {
+                ip = code + in->a;
+                Gc::safepoint();
+            }
+            VM_NEXT();
+
+            VM_CASE(JUMP_IF_FALSE): {
+                bool cond = stack.back().truthy();
+                stack.pop_back();
+                if (!cond) ip = code + in->a;
+            }
+            VM_NEXT();
+
+            VM_CASE(BUILD_ARRAY): {
+                auto vec = make_rc<Array>(
+                    std::make_move_iterator(stack.end() - in->a),
+                    std::make_move_iterator(stack.end()));
+                stack.resize(stack.size() - in->a);
+                stack.push_back(Value(vec));
+            }
+            VM_NEXT();
+
+            VM_CASE(BUILD_DICT): {
+                auto d = make_rc<Dict>();
+                size_t first = stack.size() - 2 * (size_t)in->a;
+                for (size_t i = first; i < stack.size(); i += 2)
+                    (*d)[Dict::key_of(stack[i])] = std::move(stack[i + 1]);
+                stack.resize(first);
+                stack.push_back(Value(d));
+            }
+            VM_NEXT();
+
+            VM_CASE(CONCAT): {
+                std::string result;
+                size_t first = stack.size() - in->a;
+                for (size_t i = first; i < stack.size(); i++)
+                    result += stack[i].to_string();
+                stack.resize(first);
+                stack.push_back(Value(result));
+            }
+            VM_NEXT();
+
+            VM_CASE(PRINT): {
+                std::cout << stack.back().to_string() << std::endl;
+                stack.pop_back();
+            }
+            VM_NEXT();
+
+            VM_CASE(CALL): {
+                auto* call = static_cast<FuncCallNode*>(chunk.nodes[in->b]);
+                std::vector<Value> args(std::make_move_iterator(stack.end() - in->a),
+                                        std::make_move_iterator(stack.end()));
+                stack.resize(stack.size() - in->a);
+                Value result = invoke(call, args);
+                stack.push_back(std::move(result));
+            }
+            VM_NEXT();
+
+            VM_CASE(TAIL_CALL): {
+                auto* call = static_cast<FuncCallNode*>(chunk.nodes[in->b]);
+                std::vector<Value> args(std::make_move_iterator(stack.end() - in->a),
+                                        std::make_move_iterator(stack.end()));
+                stack.resize(stack.size() - in->a);
+                if (call->cache_generation != interp.call_generation) interp.resolve_call(call);
+                if (call->target == FuncCallNode::Target::USER && !interp.frames.empty() &&
+                    call->func == interp.frames.back().func) {
+                    // This chunk is the running function's body: restart it
+                    interp.check_arity(call->func, args.size());
+                    stack.resize(base);
+                    handlers.clear();
+                    interp.bind_params(call->func, args);
+                    locals = interp.frames.back().locals.data();
+                    ip = code;
+                } else {
+                    // Not a self call after all; the RETURN that follows returns the result
+                    Value result = invoke(call, args);
+                    stack.push_back(std::move(result));
+                }
+            }
+            VM_NEXT();
+
+            VM_CASE(RETURN): {
+                Value result = pop();
+                stack.resize(base);
+                return result;
+            }
+
+            VM_CASE(FOR_PREP): {
+                // Same coercion as the tree walker: non-numbers count as 0
+                double end = stack.back().number();
+                double start = stack[stack.size() - 2].number();
+                stack[stack.size() - 2] = Value(start);
+                stack.back() = Value(end);
+            }
+            VM_NEXT();
+
+            VM_CASE(FOR_TEST): {
+                if (!(stack[stack.size() - 2].number() <= stack.back().number()))
+                    ip = code + in->a;
+            }
+            VM_NEXT();
+
+            VM_CASE(FOR_STORE_LOCAL): {
+                Interpreter::VarSlot& slot = locals[in->a];
+                slot.value.set_number(stack[stack.size() - 2].number());
+                slot.defined = true;
+            }
+            VM_NEXT();
+
+            VM_CASE(FOR_STORE_GLOBAL): {
+                Interpreter::VarSlot& slot = interp.globals[in->a];
+                slot.value.set_number(stack[stack.size() - 2].number());
+                slot.defined = true;
+            }
+            VM_NEXT();
+
+            VM_CASE(FOR_STEP): {
+                Value& counter = stack[stack.size() - 2];
+                counter.set_number(counter.number() + 1);
+            }
+            VM_NEXT();
+
+            VM_CASE(TRY_BEGIN): {
+                handlers.push_back(Handler{(size_t)in->a, stack.size(),
+                                           static_cast<TryCatchNode*>(chunk.nodes[in->b])});
+            }
+            VM_NEXT();
+
+            VM_CASE(TRY_END): {
+                handlers.pop_back();
+            }
+            VM_NEXT();
+
+            VM_CASE(EVAL): {
+                Value v = interp.evaluate(chunk.nodes[in->b]);
+                stack.push_back(std::move(v));
+            }
+            VM_NEXT();
+
+            VM_CASE(EXEC): {
+                // Loop jumps and Return are compiled, so only a stray Break/Continue
+                // can come back with a non-NORMAL status
+                ExecStatus status = interp.execute_statement(chunk.nodes[in->b]);
+                if (status != ExecStatus::NORMAL) Interpreter::outside_loop(status);
+            }
+            VM_NEXT();
+#ifndef LANG_VM_COMPUTED_GOTO
+            }
+            }
+#endif
+        } catch (const std::exception& e) {
+            if (handlers.empty()) {
+                stack.resize(base);
+                throw;
+            }
+            Handler h = handlers.back();
+            handlers.pop_back();
+            stack.resize(h.stack_depth);
+            interp.assign_variable(h.node->error_ref) = Value(std::string(e.what()));
+            ip = code + h.target;
+        } catch (...) {
+            stack.resize(base);
+            throw;
+        }
+    }
+
+#undef VM_CASE
+#undef VM_NEXT
+#ifdef LANG_VM_COMPUTED_GOTO
+  #undef VM_LABEL
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "compiler.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// VM — stack machine for Chunks produced by the Compiler. Selected with
+// --engine=vm. Shares variables, frames and built-ins with the Interpreter,
+// so bytecode and tree-walked code can call each other freely.
+class VM {
+public:
+    explicit VM(Interpreter& interp) : interp(interp) {}
+
+    void run_program(const std::vector<NodePtr>& program);
+    Value call(FuncDefNode* func, std::vector<Value>& args);
+
+private:
+    struct Handler {
+        size_t target;        // first instruction of the Catch body
+        size_t stack_depth;
+        TryCatchNode* node;
+    };
+
+    Interpreter& interp;
+    Compiler compiler;
+    std::vector<Value> stack;
+    std::vector<std::unique_ptr<Chunk>> programs;   // kept alive: imports may define functions
+    std::unordered_map<FuncDefNode*, std::unique_ptr<Chunk>> function_chunks;
+
+    const Chunk& function_chunk(FuncDefNode* func);
+    Value invoke(FuncCallNode* call, std::vector<Value>& args);
+    Value run(const Chunk& chunk);
+};